@@ -0,0 +1,28 @@
+#include <cstdlib>
+#include <new>
+#include "Profile.hpp"
+
+//count the allocations of each thread for the profiles
+void* operator new( std::size_t size )
+{
+   ++gams::allocation_count;
+   gams::allocated_bytes += size;
+
+   while( true )
+   {
+      if( void* p = std::malloc( size == 0 ? 1 : size ) )
+         return p;
+
+      std::new_handler handler = std::get_new_handler();
+
+      if( !handler )
+         throw std::bad_alloc();
+
+      handler();
+   }
+}
+
+void operator delete( void* p ) noexcept
+{
+   std::free( p );
+}
@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <sdo/Parsers.hpp>
+#include "Batch.hpp"
+#include "Conversion.hpp"
+
+namespace gams
+{
+
+namespace po = boost::program_options;
+
+/**
+ * A conversion of the manifest.
+ */
+struct BatchEntry : ConversionRequest {
+   int line; //< line of the entry in the manifest
+};
+
+/**
+ * Entries with the same control and model files, which are parsed once.
+ */
+struct BatchGroup {
+   ConversionInputs inputs; //< the control and model files of the entries
+   std::vector<const BatchEntry*> entries;
+};
+
+/**
+ * Run the given function and write the message of an error it throws to the stream.
+ *
+ * \return true if no error was thrown
+ */
+template<typename F>
+static bool run_guarded( std::ostream& messages, const std::string& context, F function )
+{
+   try
+   {
+      function();
+      return true;
+   }
+   catch( const sdo::parse_error& err )
+   {
+      messages << context << err.what() << "\n";
+   }
+   catch( const std::ifstream::failure& err )
+   {
+      messages << context << "Error: cannot read file\n";
+   }
+   catch( const std::runtime_error& err )
+   {
+      messages << context << "Error: " << err.what() << "\n";
+   }
+   //the entries are converted on worker threads, where an exception would terminate the batch
+   catch( const std::exception& err )
+   {
+      messages << context << "Error: " << err.what() << "\n";
+   }
+   catch( ... )
+   {
+      messages << context << "Error: unknown error\n";
+   }
+
+   return false;
+}
+
+int run_batch( const std::string& manifest, const po::options_description& desc, unsigned threads,
+               ConversionCache* cache, std::ostream& log )
+{
+   typedef std::chrono::steady_clock Clock;
+   Clock::time_point start = Clock::now();
+
+   std::ifstream file( manifest );
+
+   if( !file.good() )
+      throw std::runtime_error( "unable to read manifest '" + manifest + "'" );
+
+   //read all entries first, so that entries with the same model can be grouped
+   std::vector<BatchEntry> entries;
+   std::string line;
+   int failed = 0;
+
+   for( int n = 1; std::getline( file, line ); ++n )
+   {
+      std::vector<std::string> args = po::split_unix( line );
+
+      if( args.empty() || args.front()[0] == '#' )
+         continue;
+
+      std::string context = manifest + ":" + std::to_string( n ) + ": ";
+      BatchEntry entry;
+      entry.line = n;
+
+      bool valid = run_guarded( log, context, [&]()
+      {
+         static_cast<ConversionRequest&>( entry ) = get_conversion_request( args, desc );
+
+         if( entry.outputFile.empty() )
+            throw std::runtime_error( "no output file specified" );
+      } );
+
+      if( valid )
+         entries.push_back( std::move( entry ) );
+      else
+         ++failed;
+   }
+
+   std::vector<BatchGroup> groups;
+   std::map<std::pair<std::vector<std::string>, std::vector<std::string>>, std::size_t> groupOf;
+
+   for( const BatchEntry& entry : entries )
+   {
+      auto key = std::make_pair( entry.inputs.mdlFiles, entry.inputs.vocFiles );
+      auto group = groupOf.find( key );
+
+      if( group == groupOf.end() )
+      {
+         group = groupOf.emplace( key, groups.size() ).first;
+         groups.emplace_back();
+         groups.back().inputs.mdlFiles = entry.inputs.mdlFiles;
+         groups.back().inputs.vocFiles = entry.inputs.vocFiles;
+      }
+
+      groups[group->second].entries.push_back( &entry );
+   }
+
+   if( threads == 0 )
+      threads = std::max( 1u, std::thread::hardware_concurrency() );
+
+   threads = std::min<unsigned>( threads, std::max<std::size_t>( groups.size(), 1 ) );
+
+   //the groups are handed out to the workers in the order of the manifest
+   std::atomic<std::size_t> next( 0 );
+   std::mutex mutex;
+   int converted = 0;
+   int parsed = 0;
+   double parseSeconds = 0.;
+   double convertSeconds = 0.;
+   std::uintmax_t bytes = 0;
+
+   auto worker = [&]()
+   {
+      for( std::size_t g = next++; g < groups.size(); g = next++ )
+      {
+         const BatchGroup& group = groups[g];
+         std::ostringstream messages;
+         sdo::ExpressionGraph exprGraph;
+         bool groupParsed = false;
+         bool valid = true;
+         double parseTime = 0.;
+         int groupConverted = 0;
+         std::uintmax_t groupBytes = 0;
+
+         //the graph is parsed when the first entry needs it
+         auto graph = [&]() -> sdo::ExpressionGraph&
+         {
+            if( !groupParsed )
+            {
+               Clock::time_point begin = Clock::now();
+               groupParsed = true;
+               valid = false;
+               parse_model( group.inputs, exprGraph );
+               valid = true;
+               parseTime = std::chrono::duration<double>( Clock::now() - begin ).count();
+            }
+
+            return exprGraph;
+         };
+
+         Clock::time_point begin = Clock::now();
+
+         for( const BatchEntry* entry : group.entries )
+         {
+            std::string context = manifest + ":" + std::to_string( entry->line ) + ": ";
+
+            //the error of the model is only written for the entry that parsed it
+            if( !valid )
+            {
+               messages << context << "skipped: model failed to parse\n";
+               continue;
+            }
+
+            bool success = run_guarded( messages, context, [&]()
+            {
+               std::ofstream out( entry->outputFile );
+
+               if( !out.good() )
+                  throw std::runtime_error( "unable to write to file '" + entry->outputFile + "'" );
+
+               if( cache )
+                  convert_cached( *cache, graph, entry->inputs, entry->options, out, entry->outputFile );
+               else
+                  convert( graph(), entry->inputs, entry->options, out, entry->outputFile );
+
+               groupBytes += out.tellp();
+            } );
+
+            if( success )
+               ++groupConverted;
+         }
+
+         double convertTime = std::chrono::duration<double>( Clock::now() - begin ).count() - parseTime;
+
+         std::lock_guard<std::mutex> lock( mutex );
+         log << messages.str();
+         parsed += groupParsed && valid;
+         converted += groupConverted;
+         failed += group.entries.size() - groupConverted;
+         parseSeconds += parseTime;
+         convertSeconds += convertTime;
+         bytes += groupBytes;
+      }
+   };
+
+   std::vector<std::thread> pool;
+
+   for( unsigned i = 1; i < threads; ++i )
+      pool.emplace_back( worker );
+
+   worker();
+
+   for( std::thread& thread : pool )
+      thread.join();
+
+   double wallSeconds = std::chrono::duration<double>( Clock::now() - start ).count();
+   log << "batch: converted " << converted << " of " << converted + failed << " entries with " << parsed << " parsed models on " << threads << " threads\n"
+       << "batch: " << wallSeconds << " s wall time, " << parseSeconds << " s parsing and " << convertSeconds << " s converting in all threads\n"
+       << "batch: " << converted / wallSeconds << " entries/s, " << bytes / wallSeconds / 1e6 << " MB/s of gams output\n";
+
+   if( cache )
+      cache->printStatistics( log );
+
+   return failed;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef _GAMS_BATCH_HPP_
+#define _GAMS_BATCH_HPP_
+
+#include <boost/program_options.hpp>
+#include <ostream>
+#include <string>
+#include "Cache.hpp"
+
+namespace gams {
+
+/**
+ * \brief Run the conversions listed in a manifest file on a pool of worker threads.
+ *
+ * Each line of the manifest holds the command line of one conversion, i.e. its input files
+ * and options, which must include an output file. Empty lines and lines starting with '#'
+ * are ignored. The entries are independent of each other, but entries with the same control
+ * and model files share one parsed graph and are converted one after another by the same worker.
+ * The errors of the entries and a throughput report are written to the given stream.
+ *
+ * \param manifest the name of the manifest file
+ * \param desc the options that are allowed in the entries
+ * \param threads the number of worker threads or 0 to use one thread per hardware thread
+ * \param cache the cache of conversion results or nullptr. The graph of a group is only parsed
+ *              if one of its entries is not in the cache.
+ * \param log the stream for the errors and the report
+ * \return the number of entries that could not be converted
+ * \throws std::runtime_error if the manifest cannot be read
+ */
+int run_batch( const std::string& manifest, const boost::program_options::options_description& desc,
+               unsigned threads, ConversionCache* cache, std::ostream& log );
+
+}
+
+#endif
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <stack>
+#include "GamsGenerator.hpp"
+
+namespace gams
+{
+
+bool GamsGenerator::isBlockVertex( FlatGraph::Index index ) const
+{
+   ExpressionGraph::Op op = flat_.getOp( index );
+
+   if( flat_.getType( index ) != ExpressionGraph::DYNAMIC_NODE || op == ExpressionGraph::INTEG
+         || op == ExpressionGraph::CONTROL || !isLive( index ) )
+      return false;
+
+   return flat_.hasSymbol( index ) || sos2LkpIds_.find( flat_.getNode( index ) ) != sos2LkpIds_.end();
+}
+
+std::vector<FlatGraph::Index> GamsGenerator::getBlockDependencies( FlatGraph::Index vertex, std::vector<FlatGraph::Index>& visitedBy ) const
+{
+   std::vector<FlatGraph::Index> dependencies;
+   std::stack<FlatGraph::Index> stack;
+
+   //the sos2 variables of a lookup are defined by its argument
+   if( flat_.getOp( vertex ) == ExpressionGraph::APPLY_LOOKUP && !flat_.hasSymbol( vertex ) )
+   {
+      stack.push( flat_.getChild2( vertex ) );
+   }
+   else
+   {
+      FlatGraph::Index children[3];
+      int n = flat_.getChildren( vertex, children );
+
+      for( int i = n - 1; i >= 0; --i )
+         stack.push( children[i] );
+   }
+
+   while( !stack.empty() )
+   {
+      FlatGraph::Index top = stack.top();
+      stack.pop();
+      countVisit();
+
+      if( flat_.getType( top ) != ExpressionGraph::DYNAMIC_NODE || visitedBy[top] == vertex )
+         continue;
+
+      visitedBy[top] = vertex;
+
+      if( isBlockVertex( top ) )
+      {
+         dependencies.push_back( top );
+         continue;
+      }
+
+      switch( flat_.getOp( top ) )
+      {
+      //values of the previous or the initial time period are known
+      case ExpressionGraph::INTEG:
+      case ExpressionGraph::INITIAL:
+      case ExpressionGraph::DELAY_FIXED:
+      case ExpressionGraph::CONTROL:
+         continue;
+
+      case ExpressionGraph::ACTIVE_INITIAL:
+         stack.push( flat_.getChild1( top ) );
+         continue;
+
+      default:
+      {
+         FlatGraph::Index children[3];
+         int n = flat_.getChildren( top, children );
+
+         for( int i = n - 1; i >= 0; --i )
+            stack.push( children[i] );
+      }
+      }
+   }
+
+   return dependencies;
+}
+
+void GamsGenerator::analyzeBlockStructure()
+{
+   blockOf_.clear();
+   loops_.clear();
+   blockCount_ = 0;
+
+   if( !blockOrdering_ )
+      return;
+
+   std::vector<FlatGraph::Index> roots;
+
+   for( auto & entry : getSymbolTable() )
+   {
+      FlatGraph::Index index = flat_.getIndex( entry.second );
+
+      if( isBlockVertex( index ) )
+         roots.push_back( index );
+   }
+
+   //sos2 lookups are reached from the symbols using them, except for lookups of reported symbols
+   std::vector<std::pair<int, FlatGraph::Index>> lookups;
+
+   for( auto & entry : sos2LkpIds_ )
+   {
+      FlatGraph::Index index = flat_.getIndex( entry.first );
+
+      if( isBlockVertex( index ) )
+         lookups.emplace_back( entry.second, index );
+   }
+
+   std::sort( lookups.begin(), lookups.end(), []( const std::pair<int, FlatGraph::Index>& a, const std::pair<int, FlatGraph::Index>& b )
+   {
+      return a.first < b.first;
+   } );
+
+   for( auto & lookup : lookups )
+      roots.push_back( lookup.second );
+
+   //iterative version of tarjan's algorithm. The strongly connected components are found in
+   //reverse topological order of the dependency graph, which is the order of evaluation
+   struct Frame {
+      FlatGraph::Index node;
+      std::vector<FlatGraph::Index> dependencies;
+      std::size_t next;
+   };
+
+   //the snapshot is complete here, as the roots above were appended if they were missing
+   std::vector<std::pair<int, int>> index( flat_.size(), std::make_pair( -1, -1 ) ); //< index and lowlink of visited nodes
+   std::vector<char> onStack( flat_.size(), false );
+   std::vector<FlatGraph::Index> visitedBy( flat_.size(), FlatGraph::NONE );
+   std::vector<FlatGraph::Index> component;
+   std::vector<Frame> frames;
+   int counter = 0;
+   blockOf_.assign( flat_.size(), -1 );
+
+   for( FlatGraph::Index root : roots )
+   {
+      if( index[root].first >= 0 )
+         continue;
+
+      frames.push_back( Frame { root, getBlockDependencies( root, visitedBy ), 0 } );
+      index[root] = std::make_pair( counter, counter );
+      ++counter;
+      component.push_back( root );
+      onStack[root] = true;
+
+      while( !frames.empty() )
+      {
+         Frame& frame = frames.back();
+
+         if( frame.next < frame.dependencies.size() )
+         {
+            FlatGraph::Index dependency = frame.dependencies[frame.next++];
+
+            if( index[dependency].first < 0 )
+            {
+               index[dependency] = std::make_pair( counter, counter );
+               ++counter;
+               component.push_back( dependency );
+               onStack[dependency] = true;
+               frames.push_back( Frame { dependency, getBlockDependencies( dependency, visitedBy ), 0 } );
+            }
+            else if( onStack[dependency] )
+            {
+               int& lowlink = index[frame.node].second;
+               lowlink = std::min( lowlink, index[dependency].first );
+            }
+
+            continue;
+         }
+
+         FlatGraph::Index node = frame.node;
+         std::pair<int, int> links = index[node];
+         bool selfLoop = std::find( frame.dependencies.begin(), frame.dependencies.end(), node ) != frame.dependencies.end();
+         frames.pop_back();
+
+         if( !frames.empty() )
+         {
+            int& lowlink = index[frames.back().node].second;
+            lowlink = std::min( lowlink, links.second );
+         }
+
+         if( links.first != links.second )
+            continue;
+
+         //node is the root of a strongly connected component
+         auto begin = std::find( component.begin(), component.end(), node );
+         std::vector<ExpressionGraph::Node*> block;
+
+         for( auto member = begin; member != component.end(); ++member )
+         {
+            onStack[*member] = false;
+            blockOf_[*member] = blockCount_;
+            block.push_back( flat_.getNode( *member ) );
+         }
+
+         component.erase( begin, component.end() );
+
+         if( block.size() > 1 || selfLoop )
+            loops_.push_back( std::move( block ) );
+
+         ++blockCount_;
+      }
+   }
+}
+
+int GamsGenerator::getOrderKey( ExpressionGraph::Node* node, int level ) const
+{
+   if( !blockOrdering_ )
+      return level;
+
+   FlatGraph::Index index = flat_.findIndex( node );
+
+   //states only depend on the previous time period and are ordered first
+   if( index == FlatGraph::NONE || static_cast<std::size_t>( index ) >= blockOf_.size() || blockOf_[index] < 0 )
+      return 0;
+
+   return blockOf_[index] + 1;
+}
+
+std::string GamsGenerator::getBlockVertexName( ExpressionGraph::Node* node )
+{
+   auto range = getSymbol( node );
+
+   if( !range.empty() )
+      return names_.getName( range.begin()->second );
+
+   const LookupData& lkpData = lkpData_[node->child1->lookup_table];
+   return "lkp_" + names_.getName( lkpData.name ) + std::to_string( sos2LkpIds_.at( node ) ) + "_lambda";
+}
+
+}
@@ -0,0 +1,242 @@
+#include <cerrno>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Cache.hpp"
+#include "ContentHash.hpp"
+
+//defined by the build with the version of the sources
+#ifndef SDOCONV_VERSION
+#define SDOCONV_VERSION "unknown"
+#endif
+
+namespace gams
+{
+
+/**
+ * Read-only memory mapping of a file.
+ */
+class MappedFile {
+public:
+   MappedFile( const std::string& name ) : data_( nullptr ), size_( 0 )
+   {
+      int fd = open( name.c_str(), O_RDONLY );
+
+      if( fd < 0 )
+         return;
+
+      struct stat info;
+
+      if( fstat( fd, &info ) == 0 )
+      {
+         good_ = true;
+         size_ = info.st_size;
+
+         //empty files cannot be mapped
+         if( size_ > 0 )
+         {
+            void* data = mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+            if( data == MAP_FAILED )
+               good_ = false;
+            else
+               data_ = static_cast<const char*>( data );
+         }
+      }
+
+      close( fd );
+   }
+
+   ~MappedFile()
+   {
+      if( data_ )
+         munmap( const_cast<char*>( data_ ), size_ );
+   }
+
+   MappedFile( const MappedFile& ) = delete;
+   MappedFile& operator=( const MappedFile& ) = delete;
+
+   bool good() const {
+      return good_;
+   }
+
+   const char* data() const {
+      return data_;
+   }
+
+   std::size_t size() const {
+      return size_;
+   }
+
+private:
+   bool good_ = false;
+   const char* data_;
+   std::size_t size_;
+};
+
+static void hash_files( ContentHash& hash, char type, const std::vector<std::string>& files )
+{
+   for( const std::string& file : files )
+   {
+      MappedFile contents( file );
+
+      if( !contents.good() )
+         throw std::runtime_error( "cannot read file '" + file + "'" );
+
+      hash.add( std::string( 1, type ) );
+      hash.add( std::to_string( contents.size() ) );
+      hash.add( contents.data(), contents.size() );
+   }
+}
+
+static bool write_file( const std::string& name, const char* data, std::size_t size )
+{
+   std::ofstream file( name, std::ios::binary );
+   file.write( data, size );
+   file.close();
+   return !file.fail();
+}
+
+ConversionCache::ConversionCache( std::string directory ) : directory_( std::move( directory ) ), hits_( 0 ), misses_( 0 ), bytesRead_( 0 )
+{
+   if( mkdir( directory_.c_str(), 0777 ) != 0 && errno != EEXIST )
+      throw std::runtime_error( "unable to create cache directory '" + directory_ + "'" );
+
+   struct stat info;
+
+   if( stat( directory_.c_str(), &info ) != 0 || !S_ISDIR( info.st_mode ) )
+      throw std::runtime_error( "cache directory '" + directory_ + "' is not a directory" );
+}
+
+std::string ConversionCache::getKey( const ConversionInputs& inputs, const ConversionOptions& options,
+                                     const std::string& outputFile ) const
+{
+   //the result depends on the choices made on the console
+   if( options.lookupType == "interactive" )
+      return std::string();
+
+   ContentHash hash;
+   //a different version may produce a different output
+   hash.add( std::string( "sdoconv " SDOCONV_VERSION ) );
+
+   hash_files( hash, 'm', inputs.mdlFiles );
+   hash_files( hash, 'c', inputs.vocFiles );
+   hash_files( hash, 'o', inputs.vpdFiles );
+
+   if( !options.scenarioFile.empty() )
+      hash_files( hash, 's', { options.scenarioFile } );
+
+   std::ostringstream ss;
+   ss << std::setprecision( 17 )
+      << int( options.discretization ) << " " << options.lookupType << " " << int( options.deadSymbols );
+
+   for( Reformulation formulation : options.formulations )
+      ss << " " << int( formulation );
+
+   ss << " " << options.smooth << " " << options.smoothing << " " << options.bigM << " " << options.digits
+      << " " << options.quotients << " " << options.simplify << " " << options.scaling
+      << " " << options.blockOrdering << " " << options.foldEquations;
+   hash.add( ss.str() );
+
+   std::string reportFile = get_report_file( options, outputFile );
+
+   if( !reportFile.empty() )
+      hash.add( reportFile.substr( reportFile.find_last_of( '/' ) + 1 ) );
+
+   return hash.str();
+}
+
+bool ConversionCache::load( const std::string& key, std::ostream& out, const std::string& reportFile )
+{
+   std::string entry = directory_ + "/" + key;
+   MappedFile gams( entry + ".gms" );
+
+   if( !gams.good() )
+   {
+      ++misses_;
+      return false;
+   }
+
+   std::size_t size = gams.size();
+
+   if( !reportFile.empty() )
+   {
+      MappedFile report( entry + "_report.gms" );
+
+      if( !report.good() )
+      {
+         ++misses_;
+         return false;
+      }
+
+      if( !write_file( reportFile, report.data(), report.size() ) )
+         throw std::runtime_error( "unable to write to file '" + reportFile + "'" );
+
+      size += report.size();
+   }
+
+   out.write( gams.data(), gams.size() );
+   ++hits_;
+   bytesRead_ += size;
+   return true;
+}
+
+void ConversionCache::store( const std::string& key, const std::string& gams, const std::string& reportFile )
+{
+   //entries are renamed into place, so that readers never see partially written files
+   std::ostringstream tmp;
+   tmp << ".tmp." << getpid() << "." << std::hash<std::thread::id>()( std::this_thread::get_id() );
+   std::string entry = directory_ + "/" + key;
+
+   if( !reportFile.empty() )
+   {
+      MappedFile report( reportFile );
+
+      if( !report.good() || !write_file( entry + "_report.gms" + tmp.str(), report.data(), report.size() ) )
+         return;
+
+      if( rename( ( entry + "_report.gms" + tmp.str() ).c_str(), ( entry + "_report.gms" ).c_str() ) != 0 )
+         return;
+   }
+
+   if( write_file( entry + ".gms" + tmp.str(), gams.data(), gams.size() ) )
+      rename( ( entry + ".gms" + tmp.str() ).c_str(), ( entry + ".gms" ).c_str() );
+}
+
+void ConversionCache::printStatistics( std::ostream& out ) const
+{
+   out << "cache: " << hits_ << " hits, " << misses_ << " misses, "
+       << bytesRead_ / 1e6 << " MB read from '" << directory_ << "'\n";
+}
+
+void convert_cached( ConversionCache& cache, const std::function<sdo::ExpressionGraph&()>& graph,
+                     const ConversionInputs& inputs, const ConversionOptions& options,
+                     std::ostream& out, const std::string& outputFile, Profile* profile )
+{
+   std::string key = cache.getKey( inputs, options, outputFile );
+
+   if( key.empty() )
+   {
+      convert( graph(), inputs, options, out, outputFile, profile );
+      return;
+   }
+
+   std::string reportFile = get_report_file( options, outputFile );
+
+   if( cache.load( key, out, reportFile ) )
+      return;
+
+   std::ostringstream gams;
+   convert( graph(), inputs, options, gams, outputFile, profile );
+   std::string result = gams.str();
+   out.write( result.data(), result.size() );
+   cache.store( key, result, reportFile );
+}
+
+}
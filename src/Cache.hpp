@@ -0,0 +1,105 @@
+#ifndef _GAMS_CACHE_HPP_
+#define _GAMS_CACHE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include "Conversion.hpp"
+
+namespace gams {
+
+/**
+ * \brief On-disk cache of conversion results.
+ *
+ * The entries are keyed by a hash of the contents of all input files, the options of the
+ * conversion and the version of sdoconv. As the control and objective files are part of the key,
+ * conversions of one model with different control or objective files never share an entry; only
+ * repeated identical conversions hit. A server keeps one parsed model for such conversions.
+ * An entry holds the gams output and, if dead symbols are
+ * reported, the report file. Entries are memory-mapped when they are read and are written
+ * to a temporary file that is renamed afterwards, so that several processes and threads can
+ * share one cache directory.
+ *
+ * The cache can be used concurrently by several threads.
+ */
+class ConversionCache {
+public:
+   /**
+    * \brief Use the given directory for the cache entries. It is created if it does not exist.
+    *
+    * \throws std::runtime_error if the directory cannot be created
+    */
+   ConversionCache( std::string directory );
+
+   /**
+    * \brief Compute the key of a conversion.
+    *
+    * \param inputs the input files, which are read
+    * \param options the options of the conversion
+    * \param outputFile the name of the output file or an empty string. Only its file name
+    *                   is part of the key and only if dead symbols are reported, since the
+    *                   report file is included by that name.
+    * \return the key or an empty string if the conversion cannot be cached
+    * \throws std::runtime_error if an input file cannot be read
+    */
+   std::string getKey( const ConversionInputs& inputs, const ConversionOptions& options,
+                       const std::string& outputFile ) const;
+
+   /**
+    * \brief Write the cached result of a conversion.
+    *
+    * \param key the key of the conversion
+    * \param out the stream the gams output is written to
+    * \param reportFile the name of the report file to write or an empty string
+    * \return true if the cache contains the conversion
+    * \throws std::runtime_error if the report file cannot be written
+    */
+   bool load( const std::string& key, std::ostream& out, const std::string& reportFile );
+
+   /**
+    * \brief Add the result of a conversion to the cache.
+    *
+    * Failures to write the entry are ignored, since the conversion itself succeeded.
+    *
+    * \param key the key of the conversion
+    * \param gams the gams output
+    * \param reportFile the name of the report file that was written for the conversion or an empty string
+    */
+   void store( const std::string& key, const std::string& gams, const std::string& reportFile );
+
+   /**
+    * \brief Write the number of hits and misses and the amount of data read from the cache.
+    */
+   void printStatistics( std::ostream& out ) const;
+
+private:
+   std::string directory_;
+   std::atomic<unsigned> hits_;
+   std::atomic<unsigned> misses_;
+   std::atomic<std::uintmax_t> bytesRead_;
+};
+
+/**
+ * \brief Convert a model using the cache.
+ *
+ * The model is only parsed if the cache does not contain the conversion, in which case the
+ * result is added to the cache.
+ *
+ * \param cache the cache
+ * \param graph returns the parsed and analyzed graph of the input files. It is only called on a cache miss.
+ * \param inputs the input files
+ * \param options the options of the conversion
+ * \param out the stream the gams output is written to
+ * \param outputFile the name of the file written by out or an empty string
+ * \param profile the profile receiving the phases of the conversion on a cache miss or nullptr
+ * \throws std::runtime_error if a file cannot be read or written
+ */
+void convert_cached( ConversionCache& cache, const std::function<sdo::ExpressionGraph&()>& graph,
+                     const ConversionInputs& inputs, const ConversionOptions& options,
+                     std::ostream& out, const std::string& outputFile, Profile* profile = nullptr );
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef _GAMS_CONTENT_HASH_HPP_
+#define _GAMS_CONTENT_HASH_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace gams {
+
+/**
+ * \brief Incremental 64 bit FNV-1a hash of contents, e.g. of files or definitions of symbols.
+ */
+class ContentHash {
+public:
+   void add( const char* data, std::size_t size )
+   {
+      for( std::size_t i = 0; i < size; ++i )
+      {
+         value_ ^= static_cast<unsigned char>( data[i] );
+         value_ *= 1099511628211ull;
+      }
+   }
+
+   /**
+    * \brief Add the string and its size, so that the boundaries between strings are part of the hash.
+    */
+   void add( const std::string& data )
+   {
+      std::string size = std::to_string( data.size() ) + ":";
+      add( size.data(), size.size() );
+      add( data.data(), data.size() );
+   }
+
+   void add( std::uint64_t data )
+   {
+      char bytes[sizeof( data )];
+      std::memcpy( bytes, &data, sizeof( data ) );
+      add( bytes, sizeof( data ) );
+   }
+
+   void add( double data )
+   {
+      char bytes[sizeof( data )];
+      std::memcpy( bytes, &data, sizeof( data ) );
+      add( bytes, sizeof( data ) );
+   }
+
+   std::uint64_t value() const {
+      return value_;
+   }
+
+   /**
+    * \brief Get the hash as a hexadecimal string.
+    */
+   std::string str() const
+   {
+      std::ostringstream ss;
+      ss << std::hex << std::setw( 16 ) << std::setfill( '0' ) << value_;
+      return ss.str();
+   }
+
+private:
+   std::uint64_t value_ = 14695981039346656037ull;
+};
+
+}
+
+#endif
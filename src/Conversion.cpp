@@ -0,0 +1,431 @@
+#include <fstream>
+#include <initializer_list>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <sdo/Parsers.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include "Conversion.hpp"
+#include "Scenarios.hpp"
+
+namespace gams
+{
+
+namespace po = boost::program_options;
+
+void add_conversion_options( po::options_description& desc )
+{
+   desc.add_options()
+   ( "discretization-method,d", po::value<std::string>()->default_value( "rk2" ), "Method used for discretization. Available: euler, rk2, rk3, rk4, imid2, igl4" )
+   ( "lookup-type,l", po::value<std::string>()->default_value( "interactive" ), "Formulation type of lookups. sos2, spline or interactive" )
+   ( "lookup-infinity,f", po::value<double>()->default_value( 1e5 ), "Value for lookup boundaries. Too small values may yield an infeasible gams-model. Too big values may result in numerical instabilities." )
+   ( "dead-symbols", po::value<std::string>()->default_value( "keep" ), "Handling of symbols that neither a state nor the objective depends on. keep, drop or report. With report they are computed from the solution after the solve statement and written to a separate include file if an output file is given." )
+   ( "smooth", po::value<double>(), "Replace abs, min, max and conditions applied to variables by smooth approximations using the given smoothing parameter, unless another formulation is chosen for the operator class." )
+   ( "abs-formulation", po::value<std::string>(), "Formulation of abs applied to variables. direct, smooth or bigm" )
+   ( "minmax-formulation", po::value<std::string>(), "Formulation of min and max applied to variables. direct, smooth or bigm" )
+   ( "condition-formulation", po::value<std::string>(), "Formulation of comparisons and logical operators applied to variables. direct, smooth or bigm" )
+   ( "digits", po::value<int>()->default_value( 0 ), "Number of significant digits of the numbers in the output. 0 writes the shortest representation of each number that reads back as the same value." )
+   ( "bigm", po::value<double>()->default_value( 1e4 ), "Big-M value for the bigm formulations if no bounds can be derived for the arguments of an operator." )
+   ( "quotients", "Replace divisions by variables with quotient variables q and constraints q*b =e= a. Divisors are only bounded away from zero if their bounds can contain zero." )
+   ( "no-simplify", "Emit operators with literal constant operands as they are instead of removing identity operations and specializing integer powers and constant logarithm bases." )
+   ( "scale", "Scale the variables and equations by the magnitudes of the variables that are estimated by a simulation of the model." )
+   ( "block-ordering", "Emit the equations in block lower triangular order and report algebraic loops as comments." )
+   ( "fold-equations", "Fold structurally identical equations into equations indexed by a new set." )
+   ( "scenarios,s", po::value<std::string>(), "CSV file with values of constants for several scenarios that are solved within one gams model. The header row names the constants and each further row contains the name of a scenario followed by the values." )
+   ;
+}
+
+ConversionOptions get_conversion_options( const po::variables_map& vm )
+{
+   ConversionOptions options;
+
+   options.lookupType = vm["lookup-type"].as<std::string>();
+
+   if( options.lookupType != "sos2" && options.lookupType != "spline" && options.lookupType != "interactive" )
+      throw std::runtime_error( "unknown lookup-type '" + options.lookupType + "'" );
+
+   std::string dead_symbols = vm["dead-symbols"].as<std::string>();
+
+   if( dead_symbols == "keep" )
+      options.deadSymbols = DeadSymbolHandling::KEEP;
+   else if( dead_symbols == "drop" )
+      options.deadSymbols = DeadSymbolHandling::DROP;
+   else if( dead_symbols == "report" )
+      options.deadSymbols = DeadSymbolHandling::REPORT;
+   else
+      throw std::runtime_error( "unknown handling of dead symbols '" + dead_symbols + "'" );
+
+   const char* formulation_options[] = { "abs-formulation", "minmax-formulation", "condition-formulation" };
+
+   for( int i = 0; i < 3; ++i )
+   {
+      std::string formulation = vm.count( "smooth" ) ? "smooth" : "direct";
+
+      if( vm.count( formulation_options[i] ) )
+         formulation = vm[formulation_options[i]].as<std::string>();
+
+      if( formulation == "direct" )
+         options.formulations[i] = Reformulation::DIRECT;
+      else if( formulation == "smooth" )
+         options.formulations[i] = Reformulation::SMOOTH;
+      else if( formulation == "bigm" )
+         options.formulations[i] = Reformulation::BIGM;
+      else
+         throw std::runtime_error( std::string( "unknown " ) + formulation_options[i] + " '" + formulation + "'" );
+   }
+
+   std::string discretization_method_name = vm["discretization-method"].as<std::string>();
+
+   if( discretization_method_name == "euler" )
+      options.discretization = sdo::ButcherTableau::EULER;
+   else if( discretization_method_name == "rk2" )
+      options.discretization = sdo::ButcherTableau::RUNGE_KUTTA_2;
+   else if( discretization_method_name == "rk3" )
+      options.discretization = sdo::ButcherTableau::RUNGE_KUTTA_3;
+   else if( discretization_method_name == "rk4" )
+      options.discretization = sdo::ButcherTableau::RUNGE_KUTTA_4;
+   else if( discretization_method_name == "imid2" )
+      options.discretization = sdo::ButcherTableau::IMPLICIT_MIDPOINT_2;
+   else if( discretization_method_name == "igl4" )
+      options.discretization = sdo::ButcherTableau::GAUSS_LEGENDRE_4;
+   else
+      throw std::runtime_error( "unknow discretization method '" + discretization_method_name + "'" );
+
+   if( vm.count( "smooth" ) )
+   {
+      options.smooth = true;
+      options.smoothing = vm["smooth"].as<double>();
+   }
+
+   options.bigM = vm["bigm"].as<double>();
+   options.digits = vm["digits"].as<int>();
+
+   if( options.digits < 0 )
+      throw std::runtime_error( "number of digits must not be negative" );
+
+   options.quotients = vm.count( "quotients" ) > 0;
+   options.simplify = vm.count( "no-simplify" ) == 0;
+   options.scaling = vm.count( "scale" ) > 0;
+   options.blockOrdering = vm.count( "block-ordering" ) > 0;
+   options.foldEquations = vm.count( "fold-equations" ) > 0;
+
+   if( vm.count( "scenarios" ) )
+      options.scenarioFile = vm["scenarios"].as<std::string>();
+
+   return options;
+}
+
+ConversionInputs get_conversion_inputs( const std::vector<std::string>& files )
+{
+   ConversionInputs inputs;
+
+   for( const std::string& file : files )
+   {
+      if( boost::algorithm::ends_with( file, ".mdl" ) )
+      {
+         inputs.mdlFiles.push_back( file );
+      }
+      else if( boost::algorithm::ends_with( file, ".voc" ) )
+      {
+         inputs.vocFiles.push_back( file );
+      }
+      else if( boost::algorithm::ends_with( file, ".vop" ) || boost::algorithm::ends_with( file, ".sdo" ) )
+      {
+         try
+         {
+            sdo::VopFile vopfile = sdo::parse_vop_file( file );
+
+            if( !vopfile.getModelFile().empty() )
+               inputs.mdlFiles.push_back( vopfile.getModelFile() );
+
+            if( !vopfile.getControlFile().empty() )
+               inputs.vocFiles.push_back( vopfile.getControlFile() );
+
+            if( !vopfile.getObjectiveFile().empty() )
+               inputs.vpdFiles.push_back( vopfile.getObjectiveFile() );
+         }
+         catch( const std::ifstream::failure& err )
+         {
+            throw std::runtime_error( "cannot read file '" + file + "': " + err.what() );
+         }
+      }
+      else if( boost::algorithm::ends_with( file, ".vpd" ) )
+      {
+         inputs.vpdFiles.push_back( file );
+      }
+      else
+      {
+         throw std::runtime_error( "unknown file type '" + file + "'" );
+      }
+   }
+
+   return inputs;
+}
+
+ConversionRequest get_conversion_request( const std::vector<std::string>& args, const po::options_description& desc )
+{
+   po::positional_options_description positional;
+   positional.add( "input-files", -1 );
+   po::variables_map vm;
+
+   try
+   {
+      po::store( po::command_line_parser( args ).options( desc ).positional( positional ).run(), vm );
+      po::notify( vm );
+   }
+   catch( const po::error& e )
+   {
+      throw std::runtime_error( e.what() );
+   }
+
+   for( const char* mode : { "batch", "serve", "watch", "cache", "profile" } )
+   {
+      if( vm.count( mode ) )
+         throw std::runtime_error( std::string( "option '--" ) + mode + "' is not allowed here" );
+   }
+
+   if( !vm.count( "input-files" ) )
+      throw std::runtime_error( "no input file specified" );
+
+   ConversionRequest request;
+   request.inputs = get_conversion_inputs( vm["input-files"].as<std::vector<std::string>>() );
+   request.options = get_conversion_options( vm );
+
+   if( vm.count( "output-file" ) )
+      request.outputFile = vm["output-file"].as<std::string>();
+
+   //there is no console to choose from
+   if( request.options.lookupType == "interactive" )
+      throw std::runtime_error( "interactive lookup-type needs a console" );
+
+   if( request.inputs.vpdFiles.size() > 1 )
+      throw std::runtime_error( "found multiple objective functions" );
+
+   return request;
+}
+
+void parse_model( const ConversionInputs& inputs, sdo::ExpressionGraph& exprGraph, Profile* profile )
+{
+   Profile::Phase phase( profile, "parse" );
+   exprGraph.useUniqueConstants( true );
+
+   for( const std::string& vocFile : inputs.vocFiles )
+   {
+      try
+      {
+         sdo::parse_voc_file( vocFile, exprGraph );
+      }
+      catch( const std::ifstream::failure& err )
+      {
+         throw std::runtime_error( "cannot read file '" + vocFile + "'" );
+      }
+   }
+
+   for( const std::string& mdlFile : inputs.mdlFiles )
+   {
+      try
+      {
+         sdo::parse_mdl_file( mdlFile, exprGraph );
+      }
+      catch( const std::ifstream::failure& err )
+      {
+         throw std::runtime_error( "cannot read file '" + mdlFile + "'" );
+      }
+   }
+
+   phase.next( "analyze" );
+   exprGraph.analyze();
+}
+
+/**
+ * Ask the callback of the options for the formulation of each lookup.
+ */
+static void choose_lookup_types( GamsGenerator& gams, const ConversionOptions& options )
+{
+   if( !options.chooseLookupType )
+      throw std::runtime_error( "interactive lookup-type needs a callback choosing the formulations" );
+
+   for( auto& entry : gams.getSymbolTable() )
+   {
+      sdo::LookupTable* lkpTable;
+
+      if( entry.second->op == sdo::ExpressionGraph::LOOKUP_TABLE )
+      {
+         lkpTable = entry.second->lookup_table;
+      }
+      else if( entry.second->op == sdo::ExpressionGraph::APPLY_LOOKUP )
+      {
+         auto range = gams.getSymbol( entry.second->child1 );
+
+         if( !range.empty() )
+            continue;
+
+         lkpTable = entry.second->child1->lookup_table;
+      }
+      else
+      {
+         continue;
+      }
+
+      std::vector<std::string> usages;
+
+      for( auto& usage : entry.second->usages )
+      {
+         std::ostringstream ss;
+         ss << usage;
+         usages.push_back( ss.str() );
+      }
+
+      LookupFormulationType type = options.chooseLookupType( entry.first, usages );
+      gams.setLookupFormulationType( lkpTable, LookupData { entry.first, type } );
+   }
+}
+
+std::string get_report_file( const ConversionOptions& options, const std::string& outputFile )
+{
+   if( options.deadSymbols != DeadSymbolHandling::REPORT || outputFile.empty() )
+      return std::string();
+
+   //the report is written next to the output file and included after the solve statement
+   std::string reportName = outputFile;
+
+   if( boost::algorithm::ends_with( reportName, ".gms" ) )
+      reportName.erase( reportName.size() - 4 );
+
+   return reportName + "_report.gms";
+}
+
+void convert( sdo::ExpressionGraph& exprGraph, const ConversionInputs& inputs, const ConversionOptions& options,
+              std::ostream& out, const std::string& outputFile, Profile* profile )
+{
+   if( inputs.vpdFiles.size() > 1 )
+      throw std::runtime_error( "found multiple objective functions" );
+
+   GamsGenerator gams( exprGraph, options.discretization );
+
+   if( options.lookupType == "sos2" )
+      gams.setLookupFormulationTypes( LookupFormulationType::SOS2 );
+   else if( options.lookupType == "interactive" )
+      choose_lookup_types( gams, options );
+
+   if( !options.scenarioFile.empty() )
+      gams.setScenarios( parse_scenario_file( options.scenarioFile ) );
+
+   gams.setEquationFolding( options.foldEquations );
+   gams.setBlockOrdering( options.blockOrdering );
+   gams.setReformulation( NonsmoothClass::ABS, options.formulations[0] );
+   gams.setReformulation( NonsmoothClass::MINMAX, options.formulations[1] );
+   gams.setReformulation( NonsmoothClass::CONDITION, options.formulations[2] );
+   gams.setBigM( options.bigM );
+   gams.setDigits( options.digits );
+   gams.setQuotientFormulation( options.quotients );
+   gams.setSimplification( options.simplify );
+   gams.setScaling( options.scaling );
+   gams.setDeadSymbolHandling( options.deadSymbols );
+   gams.setProfile( profile );
+
+   if( options.smooth )
+      gams.setSmoothingParameter( options.smoothing );
+
+   std::unique_ptr<std::ofstream> reportFile;
+
+   std::string reportName = get_report_file( options, outputFile );
+
+   if( !reportName.empty() )
+   {
+      reportFile = std::unique_ptr<std::ofstream> { new std::ofstream( reportName ) };
+
+      if( !reportFile->good() )
+         throw std::runtime_error( "unable to write to file '" + reportName + "'" );
+
+      gams.setReportInclude( reportName.substr( reportName.find_last_of( '/' ) + 1 ) );
+   }
+
+   if( !inputs.vpdFiles.empty() )
+   {
+      sdo::Objective objective;
+      sdo::parse_vpd_file( inputs.vpdFiles.front(), objective );
+      gams.addObjective( std::move( objective ) );
+   }
+   else
+   {
+      gams.addArbitraryObjective();
+   }
+
+   gams.emitGams( out );
+
+   if( reportFile )
+      gams.emitReport( *reportFile );
+}
+
+/**
+ * Anonymous file in memory that can be opened by its path in /proc.
+ */
+class MemoryFile {
+public:
+   MemoryFile( const std::string& contents )
+   {
+      fd_ = memfd_create( "sdoconv", 0 );
+
+      if( fd_ < 0 )
+         throw std::runtime_error( "unable to create a file in memory" );
+
+      for( std::size_t written = 0; written < contents.size(); )
+      {
+         ssize_t n = write( fd_, contents.data() + written, contents.size() - written );
+
+         if( n <= 0 )
+         {
+            close( fd_ );
+            throw std::runtime_error( "unable to write a file in memory" );
+         }
+
+         written += n;
+      }
+   }
+
+   ~MemoryFile()
+   {
+      close( fd_ );
+   }
+
+   MemoryFile( const MemoryFile& ) = delete;
+   MemoryFile& operator=( const MemoryFile& ) = delete;
+
+   std::string getPath() const {
+      return "/proc/self/fd/" + std::to_string( fd_ );
+   }
+
+private:
+   int fd_;
+};
+
+void convert_buffers( const ConversionBuffers& buffers, const ConversionOptions& options, std::ostream& out,
+                      Profile* profile )
+{
+   std::vector<std::unique_ptr<MemoryFile>> files;
+   ConversionInputs inputs;
+
+   auto add = [&files]( const std::string& contents, std::vector<std::string>& paths )
+   {
+      files.emplace_back( new MemoryFile( contents ) );
+      paths.push_back( files.back()->getPath() );
+   };
+
+   for( const std::string& contents : buffers.mdlContents )
+      add( contents, inputs.mdlFiles );
+
+   for( const std::string& contents : buffers.vocContents )
+      add( contents, inputs.vocFiles );
+
+   if( !buffers.vpdContents.empty() )
+      add( buffers.vpdContents, inputs.vpdFiles );
+
+   sdo::ExpressionGraph exprGraph;
+   parse_model( inputs, exprGraph, profile );
+   convert( exprGraph, inputs, options, out, std::string(), profile );
+}
+
+}
@@ -0,0 +1,164 @@
+#ifndef _GAMS_CONVERSION_HPP_
+#define _GAMS_CONVERSION_HPP_
+
+#include <sdo/ExpressionGraph.hpp>
+#include <sdo/ButcherTableau.hpp>
+#include <boost/program_options.hpp>
+#include <array>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "GamsGenerator.hpp"
+
+namespace gams {
+
+/**
+ * \brief Input files of a conversion sorted by their type.
+ *
+ * The files referenced by vop and sdo files are added to the corresponding lists.
+ */
+struct ConversionInputs {
+   std::vector<std::string> mdlFiles; //< model files that are parsed into one graph
+   std::vector<std::string> vocFiles; //< control files that are parsed before the model files
+   std::vector<std::string> vpdFiles; //< objective files of which at most one can be used
+};
+
+/**
+ * \brief Options of a conversion that are independent of its input and output files.
+ */
+struct ConversionOptions {
+   sdo::ButcherTableau::Name discretization = sdo::ButcherTableau::RUNGE_KUTTA_2;
+   std::string lookupType = "interactive"; //< sos2, spline or interactive
+   DeadSymbolHandling deadSymbols = DeadSymbolHandling::KEEP;
+   std::array<Reformulation, 3> formulations {{ Reformulation::DIRECT, Reformulation::DIRECT, Reformulation::DIRECT }}; //< indexed by NonsmoothClass
+   bool smooth = false; //< true if a smoothing parameter is given
+   double smoothing = 1e-6;
+   double bigM = 1e4;
+   int digits = 0; //< significant digits of the numbers in the output or 0 for the shortest exact representation
+   bool quotients = false;
+   bool simplify = true;
+   bool scaling = false;
+   bool blockOrdering = false;
+   bool foldEquations = false;
+   std::string scenarioFile; //< csv file with the scenarios or an empty string
+   /**
+    * Called with the name and the usages of each lookup to choose its formulation if the
+    * lookup-type is interactive.
+    */
+   std::function<LookupFormulationType( const std::string& name, const std::vector<std::string>& usages )> chooseLookupType;
+};
+
+/**
+ * \brief Contents of the input files of a conversion that are held in memory.
+ */
+struct ConversionBuffers {
+   std::vector<std::string> mdlContents; //< contents of the model files
+   std::vector<std::string> vocContents; //< contents of the control files
+   std::string vpdContents; //< contents of the objective file or an empty string
+};
+
+/**
+ * \brief A conversion given by a command line that is run without a console.
+ */
+struct ConversionRequest {
+   ConversionInputs inputs;
+   ConversionOptions options;
+   std::string outputFile; //< the output file or an empty string
+};
+
+/**
+ * \brief Add the options of a conversion to the description of the command line options.
+ *
+ * \param desc the options description
+ */
+void add_conversion_options( boost::program_options::options_description& desc );
+
+/**
+ * \brief Get the options of a conversion from parsed command line options.
+ *
+ * \param vm the parsed options, which must contain the options added by add_conversion_options()
+ * \return the conversion options
+ * \throws std::runtime_error if an option has an unknown value
+ */
+ConversionOptions get_conversion_options( const boost::program_options::variables_map& vm );
+
+/**
+ * \brief Sort the input files by their type and resolve vop and sdo files.
+ *
+ * \param files the names of the input files
+ * \return the sorted input files
+ * \throws std::runtime_error if a file has an unknown type or a vop file cannot be read
+ */
+ConversionInputs get_conversion_inputs( const std::vector<std::string>& files );
+
+/**
+ * \brief Parse the command line of a conversion that is run without a console.
+ *
+ * \param args the arguments of the command line, i.e. the input files and options
+ * \param desc the allowed options, which must contain the input and output files and the
+ *             options added by add_conversion_options()
+ * \return the conversion
+ * \throws std::runtime_error if the command line is invalid, uses another mode like --batch,
+ *         contains no input files or needs a choice on the console
+ */
+ConversionRequest get_conversion_request( const std::vector<std::string>& args,
+                                          const boost::program_options::options_description& desc );
+
+/**
+ * \brief Parse the control and model files of a conversion into a graph and analyze it.
+ *
+ * \param inputs the input files
+ * \param exprGraph the graph to parse the files into
+ * \param profile the profile receiving the parse and analyze phases or nullptr
+ * \throws std::runtime_error if a file cannot be read
+ */
+void parse_model( const ConversionInputs& inputs, sdo::ExpressionGraph& exprGraph, Profile* profile = nullptr );
+
+/**
+ * \brief Get the name of the file the report of dead symbols is written to.
+ *
+ * \param options the options of the conversion
+ * \param outputFile the name of the gams output file or an empty string
+ * \return the name of the report file next to the output file or an empty string if no
+ *         report is written
+ */
+std::string get_report_file( const ConversionOptions& options, const std::string& outputFile );
+
+/**
+ * \brief Convert a model given by the contents of its files to gams.
+ *
+ * The contents are passed to the parsers as anonymous files in memory, so nothing is written
+ * to disk. Dead symbols are reported directly after the solve statement.
+ *
+ * \param buffers the contents of the input files
+ * \param options the options of the conversion
+ * \param out the stream the gams output is written to
+ * \param profile the profile receiving the phases of the conversion or nullptr
+ * \throws std::runtime_error if the anonymous files cannot be created or the model cannot be converted
+ * \throws sdo::parse_error if a file cannot be parsed
+ */
+void convert_buffers( const ConversionBuffers& buffers, const ConversionOptions& options, std::ostream& out,
+                      Profile* profile = nullptr );
+
+/**
+ * \brief Convert a parsed model to gams.
+ *
+ * The same graph can be converted several times, e.g. with different objectives or options,
+ * but not concurrently since the symbols of hidden states and divisors are added to it.
+ *
+ * \param exprGraph the parsed and analyzed graph
+ * \param inputs the input files, of which only the objective files are read
+ * \param options the options of the conversion
+ * \param out the stream the gams output is written to
+ * \param outputFile the name of the file written by out or an empty string. The report of dead
+ *                   symbols is written next to it.
+ * \param profile the profile receiving the phases of the conversion and the emitted bytes or nullptr
+ * \throws std::runtime_error if there is more than one objective file or a file cannot be read or written
+ */
+void convert( sdo::ExpressionGraph& exprGraph, const ConversionInputs& inputs, const ConversionOptions& options,
+              std::ostream& out, const std::string& outputFile, Profile* profile = nullptr );
+
+}
+
+#endif
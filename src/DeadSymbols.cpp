@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <stack>
+#include "GamsGenerator.hpp"
+
+namespace gams
+{
+
+void GamsGenerator::analyzeLiveness()
+{
+   liveNodes_.clear();
+
+   if( deadSymbols_ == DeadSymbolHandling::KEEP )
+      return;
+
+   std::stack<FlatGraph::Index> stack;
+
+   for( Objective::Summand & s : objective_.getSummands() )
+      stack.push( flat_.getIndex( getNode( s.variable ) ) );
+
+   //the states are kept, so their derivatives and initial values are live
+   for( auto & entry : getSymbolTable() )
+   {
+      if( entry.second->op == ExpressionGraph::INTEG )
+         stack.push( flat_.getIndex( entry.second ) );
+   }
+
+   //the reported symbols reference the variables of their sos2 lookups
+   if( deadSymbols_ == DeadSymbolHandling::REPORT )
+   {
+      for( auto & entry : sos2LkpIds_ )
+         stack.push( flat_.getIndex( entry.first ) );
+   }
+
+   //the snapshot is complete here, as the roots above were appended if they were missing
+   liveNodes_.assign( flat_.size(), false );
+
+   while( !stack.empty() )
+   {
+      FlatGraph::Index top = stack.top();
+      stack.pop();
+      countVisit();
+
+      if( liveNodes_[top] )
+         continue;
+
+      liveNodes_[top] = true;
+      FlatGraph::Index children[3];
+      int n = flat_.getChildren( top, children );
+
+      for( int i = 0; i < n; ++i )
+         stack.push( children[i] );
+   }
+}
+
+void GamsGenerator::emitReport( std::ostream& stream )
+{
+   std::sort( report_.begin(), report_.end() );
+
+   for( auto & pair : report_ )
+   {
+      stream << pair.second;
+   }
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef _GAMS_DISCRETIZATION_HPP_
+#define _GAMS_DISCRETIZATION_HPP_
+
+#include <array>
+#include <cstddef>
+#include "SetIndex.hpp"
+
+namespace gams {
+
+/**
+ * \brief Maximal number of sets indexing the variables of a discretization.
+ */
+constexpr std::size_t MAX_INDEX_COUNT = 2;
+
+/**
+ * \brief Index shape of the euler method, whose variables are only indexed by the time.
+ */
+struct EulerShape {
+   static constexpr bool STAGED = false;
+   static constexpr std::size_t INDEX_COUNT = 1;
+
+   static std::array<SetIndex, INDEX_COUNT> getVarSets() {
+      return {{ SetId::T }};
+   }
+
+   static std::array<SetIndex, INDEX_COUNT> getInitialSets() {
+      return {{ SetIndex::First( SetId::T ) }};
+   }
+};
+
+/**
+ * \brief Index shape of the runge-kutta methods, whose variables are indexed by the time and the stage.
+ *
+ * The explicit and implicit methods and the collocation methods only differ in the coefficients
+ * of their butcher tableau, so they share this shape.
+ */
+struct StagedShape {
+   static constexpr bool STAGED = true;
+   static constexpr std::size_t INDEX_COUNT = 2;
+
+   static std::array<SetIndex, INDEX_COUNT> getVarSets() {
+      return {{ SetId::T, SetId::P }};
+   }
+
+   static std::array<SetIndex, INDEX_COUNT> getInitialSets() {
+      return {{ SetIndex::First( SetId::T ), SetIndex::First( SetId::P ) }};
+   }
+};
+
+}
+
+#endif
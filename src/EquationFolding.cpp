@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include "GamsGenerator.hpp"
+
+namespace gams
+{
+
+/**
+ * A leaf that is translated as a number, i.e. its value is the same in each time period.
+ */
+static bool is_constant_leaf( const std::pair<ExpressionGraph::Node*, bool>& leaf )
+{
+   ExpressionGraph::Node* node = leaf.first;
+   return node->op == ExpressionGraph::CONSTANT || node->type == ExpressionGraph::CONSTANT_NODE
+          || ( leaf.second && node->op != ExpressionGraph::INTEG );
+}
+
+bool GamsGenerator::getStructuralKey( FlatGraph::Index index, bool initial, bool root, std::string& key,
+                                      std::vector<std::pair<ExpressionGraph::Node*, bool>>& leaves )
+{
+   countVisit();
+   ExpressionGraph::Op op = flat_.getOp( index );
+
+   if( op == ExpressionGraph::CONSTANT || ( !root && flat_.hasSymbol( index ) ) )
+   {
+      //constants are the same in initial translation, the other symbols are not
+      std::pair<ExpressionGraph::Node*, bool> leaf( flat_.getNode( index ), initial && flat_.getType( index ) != ExpressionGraph::CONSTANT_NODE );
+      auto pos = std::find( leaves.begin(), leaves.end(), leaf );
+      key += is_constant_leaf( leaf ) ? 'c' : 'r';
+      key += std::to_string( pos - leaves.begin() );
+      key += ',';
+
+      if( pos == leaves.end() )
+         leaves.push_back( leaf );
+
+      return true;
+   }
+
+   switch( op )
+   {
+   case ExpressionGraph::INITIAL:
+      key += "N(";
+
+      if( !getStructuralKey( flat_.getChild1( index ), true, false, key, leaves ) )
+         return false;
+
+      key += ')';
+      return true;
+
+   case ExpressionGraph::ACTIVE_INITIAL:
+      return getStructuralKey( initial ? flat_.getChild2( index ) : flat_.getChild1( index ), initial, false, key, leaves );
+
+   case ExpressionGraph::APPLY_LOOKUP:
+   {
+      LookupTable* table = flat_.getNode( index )->child1->lookup_table;
+
+      //sos2 lookups have variables for each call
+      if( initial || lkpData_[table].type == LookupFormulationType::SOS2 )
+         return false;
+
+      key += 'L';
+      key += std::to_string( reinterpret_cast<std::uintptr_t>( table ) );
+      key += '(';
+
+      if( !getStructuralKey( flat_.getChild2( index ), initial, false, key, leaves ) )
+         return false;
+
+      key += ')';
+      return true;
+   }
+
+   case ExpressionGraph::INTEG:
+   case ExpressionGraph::DELAY_FIXED:
+   case ExpressionGraph::PULSE_TRAIN:
+   case ExpressionGraph::RANDOM_UNIFORM:
+   case ExpressionGraph::CONTROL:
+   case ExpressionGraph::LOOKUP_TABLE:
+   case ExpressionGraph::NIL:
+      return false;
+
+   default:
+   {
+      ExpressionGraph::Node* node = flat_.getNode( index );
+
+      //the auxiliary variables of big-M formulations and quotients belong to one node
+      if( !initial && ( bigmIds_.find( node ) != bigmIds_.end() || quotientIds_.find( node ) != quotientIds_.end() ) )
+         return false;
+
+      FlatGraph::Index children[3];
+      int n = flat_.getChildren( index, children );
+      key += std::to_string( op );
+      key += '(';
+
+      //children are stored in reverse order
+      for( int i = n - 1; i >= 0; --i )
+      {
+         if( !getStructuralKey( children[i], initial, false, key, leaves ) )
+            return false;
+      }
+
+      key += ')';
+      return true;
+   }
+   }
+}
+
+void GamsGenerator::foldIsomorphicEquations()
+{
+   families_.clear();
+   foldedMembers_.clear();
+
+   if( !foldEquations_ )
+      return;
+
+   struct Candidate {
+      ExpressionGraph::Node* node;
+      Symbol symbol;
+      std::string name;
+      std::vector<std::pair<ExpressionGraph::Node*, bool>> leaves;
+   };
+
+   //group the symbols by the structural key of their definition
+   std::unordered_map<std::string, std::vector<Candidate>> buckets;
+
+   for( auto & entry : getSymbolTable() )
+   {
+      ExpressionGraph::Node* node = entry.second;
+
+      if( node->type != ExpressionGraph::DYNAMIC_NODE || node->op == ExpressionGraph::CONTROL || isScenarioNode( node ) || !isLive( node ) )
+         continue;
+
+      auto range = getSymbol( node );
+
+      if( std::distance( range.begin(), range.end() ) != 1 )
+         continue;
+
+      if( node->op == ExpressionGraph::APPLY_LOOKUP && lkpData_[node->child1->lookup_table].type == LookupFormulationType::SOS2 )
+         continue;
+
+      Candidate candidate { node, entry.first, names_.getName( entry.first ), {} };
+      std::string key;
+      bool foldable;
+
+      if( node->op == ExpressionGraph::INTEG )
+      {
+         key = node->init == ExpressionGraph::CONSTANT_INIT ? "I(" : "J(";
+         FlatGraph::Index index = flat_.getIndex( node );
+         foldable = getStructuralKey( flat_.getChild1( index ), false, false, key, candidate.leaves );
+         key += '|';
+         foldable = foldable && getStructuralKey( flat_.getChild2( index ), true, false, key, candidate.leaves );
+      }
+      else
+      {
+         foldable = getStructuralKey( flat_.getIndex( node ), false, true, key, candidate.leaves );
+      }
+
+      if( foldable )
+         buckets[key].push_back( std::move( candidate ) );
+   }
+
+   std::vector<std::vector<Candidate>*> groups;
+
+   for( auto & bucket : buckets )
+   {
+      if( bucket.second.size() < 2 )
+         continue;
+
+      std::sort( bucket.second.begin(), bucket.second.end(), []( const Candidate & a, const Candidate & b )
+      {
+         return a.name < b.name;
+      } );
+      groups.push_back( &bucket.second );
+   }
+
+   std::sort( groups.begin(), groups.end(), []( const std::vector<Candidate>* a, const std::vector<Candidate>* b )
+   {
+      return a->front().name < b->front().name;
+   } );
+
+   std::unordered_map<ExpressionGraph::Node*, int> groupOf;
+
+   for( std::size_t g = 0; g < groups.size(); ++g )
+   {
+      for( Candidate & c : *groups[g] )
+         groupOf[c.node] = g;
+   }
+
+   //a group can only be folded if all symbols that differ between its members are members of one other group
+   std::vector<bool> valid( groups.size(), true );
+   bool changed = true;
+
+   while( changed )
+   {
+      changed = false;
+
+      for( std::size_t g = 0; g < groups.size(); ++g )
+      {
+         if( !valid[g] )
+            continue;
+
+         const std::vector<Candidate>& members = *groups[g];
+
+         for( std::size_t j = 0; j < members.front().leaves.size() && valid[g]; ++j )
+         {
+            const auto& first = members.front().leaves[j];
+
+            if( is_constant_leaf( first ) )
+               continue;
+
+            bool same = std::all_of( members.begin(), members.end(), [&]( const Candidate & c )
+            {
+               return c.leaves[j] == first;
+            } );
+
+            if( same )
+               continue;
+
+            auto target = groupOf.find( first.first );
+            bool folded = target != groupOf.end() && std::all_of( members.begin(), members.end(), [&]( const Candidate & c )
+            {
+               auto t = groupOf.find( c.leaves[j].first );
+               return t != groupOf.end() && t->second == target->second;
+            } );
+
+            if( !folded )
+            {
+               valid[g] = false;
+               changed = true;
+
+               for( const Candidate & c : members )
+                  groupOf.erase( c.node );
+            }
+         }
+      }
+   }
+
+   std::vector<int> familyOf( groups.size(), -1 );
+
+   for( std::size_t g = 0; g < groups.size(); ++g )
+   {
+      if( !valid[g] )
+         continue;
+
+      familyOf[g] = families_.size();
+      families_.emplace_back();
+      FoldedFamily& family = families_.back();
+
+      for( std::size_t i = 0; i < groups[g]->size(); ++i )
+      {
+         const Candidate& c = ( *groups[g] )[i];
+         family.members.push_back( c.node );
+         family.symbols.push_back( c.symbol );
+         family.level = std::max( family.level, c.node->level );
+         foldedMembers_[c.node] = std::make_pair( familyOf[g], int( i ) );
+      }
+   }
+
+   //determine how the leaves that differ between the members are replaced
+   for( std::size_t g = 0; g < groups.size(); ++g )
+   {
+      if( !valid[g] )
+         continue;
+
+      const std::vector<Candidate>& members = *groups[g];
+      FoldedFamily& family = families_[familyOf[g]];
+
+      for( std::size_t j = 0; j < members.front().leaves.size(); ++j )
+      {
+         const auto& first = members.front().leaves[j];
+
+         if( is_constant_leaf( first ) )
+         {
+            std::vector<double> values;
+
+            for( const Candidate & c : members )
+               values.push_back( c.leaves[j].first->value );
+
+            if( std::all_of( values.begin(), values.end(), [&]( double v ) { return v == values.front(); } ) )
+               continue;
+
+            family.leaves[first.second][first.first] = FoldedLeaf { FoldedLeaf::PARAMETER, int( family.parameters.size() ), -1 };
+            family.parameters.push_back( std::move( values ) );
+            continue;
+         }
+
+         std::vector<int> positions;
+         int target = -1;
+
+         for( std::size_t i = 0; i < members.size(); ++i )
+         {
+            auto folded = foldedMembers_.find( members[i].leaves[j].first );
+
+            if( folded != foldedMembers_.end() )
+            {
+               target = folded->second.first;
+               positions.push_back( folded->second.second );
+            }
+         }
+
+         //leaf is the same symbol for all members
+         if( positions.size() != members.size() || std::all_of( members.begin(), members.end(), [&]( const Candidate & c ) { return c.leaves[j] == first; } ) )
+            continue;
+
+         bool identity = true;
+
+         for( std::size_t i = 0; i < positions.size(); ++i )
+            identity = identity && positions[i] == int( i );
+
+         if( identity )
+         {
+            family.leaves[first.second][first.first] = FoldedLeaf { FoldedLeaf::REFERENCE, -1, target };
+         }
+         else
+         {
+            family.leaves[first.second][first.first] = FoldedLeaf { FoldedLeaf::MAPPED_REFERENCE, int( family.maps.size() ), target };
+            family.maps.emplace_back( target, std::move( positions ) );
+         }
+      }
+   }
+}
+
+void GamsGenerator::translateFamilyMember( std::ostream& stream, int family, const std::string& element, bool initial )
+{
+   ExpressionGraph::Node* node = families_[family].members.front();
+   stream << "v_fold" << family + 1;
+
+   if( initial )
+   {
+      if( node->init == ExpressionGraph::CONSTANT_INIT )
+         stream << ".lo";
+      else if( reportContext_ )
+         stream << ".l";
+
+      stream << "(" << element << ", " << getInitialSets() << ")";
+   }
+   else
+   {
+      stream << ( reportContext_ ? ".l(" : "(" ) << element << ", " << getVarSets() << ")";
+   }
+}
+
+void GamsGenerator::translateFoldedLeaf( std::ostream& stream, const FoldedLeaf& leaf, bool initial )
+{
+   int k = foldContext_ - families_.data() + 1;
+
+   switch( leaf.kind )
+   {
+   case FoldedLeaf::PARAMETER:
+      stream << "c_fold" << k << "_" << leaf.column + 1 << "(fi)";
+      break;
+
+   case FoldedLeaf::REFERENCE:
+      translateFamilyMember( stream, leaf.family, "fi", initial );
+      break;
+
+   case FoldedLeaf::MAPPED_REFERENCE:
+      stream << "sum(fj$m_fold" << k << "_" << leaf.column + 1 << "(fi, fj), ";
+      translateFamilyMember( stream, leaf.family, "fj", initial );
+      stream << ")";
+      break;
+   }
+}
+
+}
@@ -1,4 +1,9 @@
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "Escape.hpp"
 
 namespace gams
@@ -12,47 +17,155 @@ struct isVocale
    }
 };
 
-struct isIllegal
+//first code point of the transliteration table
+static const std::uint32_t TABLE_BEGIN = 0xC0;
+
+/**
+ * Transliterations of the letters of Latin-1 and Latin Extended-A starting at U+00C0.
+ * The empty strings are the multiplication and division signs, which are removed.
+ */
+static const char* const TRANSLITERATIONS[] = {
+   //U+00C0
+   "A", "A", "A", "A", "AE", "A", "AE", "C", "E", "E", "E", "E", "I", "I", "I", "I",
+   "D", "N", "O", "O", "O", "O", "OE", "", "O", "U", "U", "U", "UE", "Y", "TH", "ss",
+   "a", "a", "a", "a", "ae", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+   "d", "n", "o", "o", "o", "o", "oe", "", "o", "u", "u", "u", "ue", "y", "th", "y",
+   //U+0100
+   "A", "a", "A", "a", "A", "a", "C", "c", "C", "c", "C", "c", "C", "c", "D", "d",
+   "D", "d", "E", "e", "E", "e", "E", "e", "E", "e", "E", "e", "G", "g", "G", "g",
+   "G", "g", "G", "g", "H", "h", "H", "h", "I", "i", "I", "i", "I", "i", "I", "i",
+   "I", "i", "IJ", "ij", "J", "j", "K", "k", "k", "L", "l", "L", "l", "L", "l", "L",
+   "l", "L", "l", "N", "n", "N", "n", "N", "n", "n", "N", "n", "O", "o", "O", "o",
+   "O", "o", "OE", "oe", "R", "r", "R", "r", "R", "r", "S", "s", "S", "s", "S", "s",
+   "S", "s", "T", "t", "T", "t", "T", "t", "U", "u", "U", "u", "U", "u", "U", "u",
+   "U", "u", "U", "u", "W", "w", "Y", "y", "Y", "Z", "z", "Z", "z", "Z", "z", "s"
+};
+
+static const std::uint32_t TABLE_END = TABLE_BEGIN + sizeof( TRANSLITERATIONS ) / sizeof( TRANSLITERATIONS[0] );
+
+/**
+ * Get the number of leading bytes that are copied unchanged, i.e. that are ascii and neither
+ * a space nor a dash.
+ */
+static std::size_t count_plain_bytes( const char* str, std::size_t size )
 {
-   bool operator()( char c ) const
+   std::size_t i = 0;
+#ifdef __SSE2__
+   const __m128i space = _mm_set1_epi8( ' ' );
+   const __m128i dash = _mm_set1_epi8( '-' );
+
+   for( ; i + 16 <= size; i += 16 )
+   {
+      __m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i*>( str + i ) );
+      //the mask of the bytes themselves flags the non-ascii bytes
+      __m128i special = _mm_or_si128( bytes, _mm_or_si128( _mm_cmpeq_epi8( bytes, space ), _mm_cmpeq_epi8( bytes, dash ) ) );
+      int mask = _mm_movemask_epi8( special );
+
+      if( mask != 0 )
+         return i + __builtin_ctz( mask );
+   }
+#else
+   const std::uint64_t ones = 0x0101010101010101ull;
+   const std::uint64_t highs = 0x8080808080808080ull;
+
+   for( ; i + 8 <= size; i += 8 )
    {
-      return c == ' ' || c == '-';
+      std::uint64_t bytes;
+      std::memcpy( &bytes, str + i, 8 );
+      std::uint64_t space = bytes ^ ( ones * ' ' );
+      std::uint64_t dash = bytes ^ ( ones * '-' );
+      //a byte of space or dash is zero where the input has a space or a dash
+      std::uint64_t special = bytes | ( ( space - ones ) & ~space ) | ( ( dash - ones ) & ~dash );
+
+      if( special & highs )
+         break;
    }
-};
+#endif
+
+   while( i < size && static_cast<unsigned char>( str[i] ) < 0x80 && str[i] != ' ' && str[i] != '-' )
+      ++i;
+
+   return i;
+}
 
-void replace_string_inplace( std::string& subject, const std::string& search,
-                             const std::string& replace )
+/**
+ * Decode the utf-8 sequence at the start of the string. A byte that does not start a valid
+ * sequence is decoded as a Latin-1 character, so that files in Latin-1 are handled as well.
+ *
+ * \return the number of bytes of the sequence
+ */
+static std::size_t decode( const unsigned char* str, std::size_t size, std::uint32_t& codePoint )
 {
-   std::size_t pos = 0;
+   unsigned char lead = str[0];
+   std::size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC2 ? 2 : 1;
 
-   while( ( pos = subject.find( search, pos ) ) != std::string::npos )
+   if( length > 1 && length <= size && lead < 0xF5 )
    {
-      subject.replace( pos, search.length(), replace );
-      pos += replace.length();
+      std::uint32_t value = lead & ( 0x7F >> length );
+      std::size_t i = 1;
+
+      for( ; i < length && ( str[i] & 0xC0 ) == 0x80; ++i )
+         value = ( value << 6 ) | ( str[i] & 0x3F );
+
+      if( i == length )
+      {
+         codePoint = value;
+         return length;
+      }
    }
+
+   codePoint = lead;
+   return 1;
 }
 
-std::string escape_string( std::string str )
+std::size_t transliterate( const char* str, std::size_t size, char* out )
 {
-   str.erase( std::remove_if( str.begin(), str.end(), isIllegal() ), str.end() );
+   std::size_t length = 0;
+   std::size_t i = 0;
+
+   while( i < size )
+   {
+      std::size_t plain = count_plain_bytes( str + i, size - i );
+      std::memcpy( out + length, str + i, plain );
+      length += plain;
+      i += plain;
+
+      if( i == size )
+         break;
 
-   //replace forbidden characters
-   replace_string_inplace( str, "Ä", "AE" );
-   replace_string_inplace( str, "Ö", "OE" );
-   replace_string_inplace( str, "Ü", "UE" );
-   replace_string_inplace( str, "ä", "ae" );
-   replace_string_inplace( str, "ö", "oe" );
-   replace_string_inplace( str, "ü", "ue" );
-   replace_string_inplace( str, "ß", "ss" );
+      if( str[i] == ' ' || str[i] == '-' )
+      {
+         ++i;
+         continue;
+      }
+
+      std::uint32_t codePoint;
+      i += decode( reinterpret_cast<const unsigned char*>( str + i ), size - i, codePoint );
+
+      //characters that are not in the table cannot be part of an identifier and are removed
+      if( codePoint >= TABLE_BEGIN && codePoint < TABLE_END )
+      {
+         for( const char* c = TRANSLITERATIONS[codePoint - TABLE_BEGIN]; *c; ++c )
+            out[length++] = *c;
+      }
+   }
+
+   return length;
+}
+
+std::string escape_string( const std::string& str )
+{
+   std::string escaped( 2 * str.size(), '\0' );
+   escaped.resize( transliterate( str.data(), str.size(), &escaped[0] ) );
 
    //if too long remove vocales
-   if( str.size() > 59 )
-      str.erase( std::remove_if( str.begin(), str.end(), isVocale() ), str.end() );
+   if( escaped.size() > 59 )
+      escaped.erase( std::remove_if( escaped.begin(), escaped.end(), isVocale() ), escaped.end() );
 
    //if still too long cut off end
-   if( str.size() > 59 )
-      str.erase( str.begin() + 59, str.end() );
+   if( escaped.size() > 59 )
+      escaped.erase( escaped.begin() + 59, escaped.end() );
 
-   return str;
+   return escaped;
 }
 }
@@ -1,17 +1,34 @@
 #ifndef _GAMS_ESCAPE_HPP_
 #define _GAMS_ESCAPE_HPP_
 
+#include <cstddef>
 #include <string>
 
 namespace gams {
 
+/**
+ * \brief Remove spaces and dashes and transliterate the letters of Latin-1 and Latin Extended-A to ascii.
+ * 
+ * The string is decoded as utf-8, but bytes that do not start a valid utf-8 sequence are taken
+ * as Latin-1 characters. Other non-ascii characters are removed.
+ * 
+ * \param str the string to transliterate
+ * \param size the number of bytes of the string
+ * \param out the buffer receiving the result, which needs room for 2 * size bytes
+ * \return the number of bytes written to out
+ */
+std::size_t transliterate( const char* str, std::size_t size, char* out );
+
 /**
  * \brief Escape string so that it becomes suitable as an identifier in gams.
  * 
+ * The string is transliterated and shortened to 59 characters by removing vocales
+ * and cutting off the end if needed.
+ * 
  * \param str the string to escape
  * \return the escaped string
  */
-std::string escape_string( std::string str );
+std::string escape_string( const std::string& str );
 
 }
 
@@ -0,0 +1,97 @@
+#include <stack>
+#include <utility>
+#include "FlatGraph.hpp"
+
+namespace gams
+{
+
+constexpr FlatGraph::Index FlatGraph::NONE;
+
+void FlatGraph::build( const ExpressionGraph::SymbolTable& symbols, const NodeSymbols& nodeSymbols )
+{
+   *this = FlatGraph();
+   nodeSymbols_ = &nodeSymbols;
+
+   for( auto & entry : symbols )
+   {
+      if( indices_.find( entry.second ) == indices_.end() )
+         add( entry.second );
+   }
+}
+
+void FlatGraph::addSymbol( ExpressionGraph::Node* node, const sdo::Symbol& symbol )
+{
+   Index index = findIndex( node );
+
+   if( index == NONE || symbols_[index] != NONE )
+      return;
+
+   symbols_[index] = symbolList_.size();
+   symbolList_.push_back( symbol );
+}
+
+FlatGraph::Index FlatGraph::add( ExpressionGraph::Node* root )
+{
+   std::size_t begin = nodes_.size();
+   //the nodes on the stack are in the map with the index NONE, so cycles end at them
+   std::stack<std::pair<int, ExpressionGraph::Node*>> stack;
+   stack.emplace( 0, root );
+   indices_.emplace( root, NONE );
+
+   while( !stack.empty() )
+   {
+      std::pair<int, ExpressionGraph::Node*>& top = stack.top();
+      ExpressionGraph::Node* node = top.second;
+      ExpressionGraph::Node* child = nullptr;
+
+      while( !child && top.first < 3 )
+      {
+         child = top.first == 0 ? node->child1 : top.first == 1 ? node->child2 : node->child3;
+         ++top.first;
+
+         if( child && !indices_.emplace( child, NONE ).second )
+            child = nullptr;
+      }
+
+      if( child )
+      {
+         stack.emplace( 0, child );
+         continue;
+      }
+
+      indices_[node] = nodes_.size();
+      nodes_.push_back( node );
+      stack.pop();
+   }
+
+   auto index = [this]( ExpressionGraph::Node* node )
+   {
+      return node ? indices_[node] : NONE;
+   };
+
+   for( std::size_t i = begin; i < nodes_.size(); ++i )
+   {
+      ExpressionGraph::Node* node = nodes_[i];
+      auto range = nodeSymbols_->equal_range( node );
+      ops_.push_back( node->op );
+      types_.push_back( node->type );
+      child1_.push_back( index( node->child1 ) );
+      child2_.push_back( index( node->child2 ) );
+      child3_.push_back( index( node->child3 ) );
+      values_.push_back( node->value );
+
+      if( range.first == range.second )
+      {
+         symbols_.push_back( NONE );
+      }
+      else
+      {
+         symbols_.push_back( symbolList_.size() );
+         symbolList_.push_back( range.first->second );
+      }
+   }
+
+   return indices_[root];
+}
+
+}
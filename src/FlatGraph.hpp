@@ -0,0 +1,140 @@
+#ifndef _GAMS_FLAT_GRAPH_HPP_
+#define _GAMS_FLAT_GRAPH_HPP_
+
+#include <sdo/ExpressionGraph.hpp>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "NodeChildren.hpp"
+
+namespace gams {
+
+using sdo::ExpressionGraph;
+
+/**
+ * \brief The symbols of each node in the order they were added.
+ */
+typedef std::multimap<ExpressionGraph::Node*, sdo::Symbol> NodeSymbols;
+
+/**
+ * \brief Snapshot of the nodes of an expression graph as a structure of arrays.
+ *
+ * The nodes reachable from the symbols are numbered in post order, so that the children of
+ * a node come before it unless they are part of a cycle through it. The fields that translate
+ * reads for every visited node are stored in arrays indexed by that number, and the children are
+ * stored by their numbers, so that a walk over the graph needs no lookup by node.
+ *
+ * The snapshot is not updated when the graph changes, except for the symbols passed to addSymbol().
+ * Nodes that were not reachable when it was built are appended when their index is requested.
+ */
+class FlatGraph {
+public:
+   typedef int Index;
+
+   /**
+    * \brief Index of a missing child and the symbol id of a node without a symbol.
+    */
+   static constexpr Index NONE = -1;
+
+   /**
+    * \brief Number the nodes reachable from the symbols.
+    *
+    * The symbols are referenced and not copied, as the nodes appended later look up theirs.
+    */
+   void build( const ExpressionGraph::SymbolTable& symbols, const NodeSymbols& nodeSymbols );
+
+   /**
+    * \brief Get the index of a node and append the node with its descendants if it is not numbered yet.
+    */
+   Index getIndex( ExpressionGraph::Node* node ) {
+      auto found = indices_.find( node );
+      return found != indices_.end() ? found->second : add( node );
+   }
+
+   /**
+    * \brief Get the index of a numbered node or NONE.
+    */
+   Index findIndex( ExpressionGraph::Node* node ) const {
+      auto found = indices_.find( node );
+      return found != indices_.end() ? found->second : NONE;
+   }
+
+   /**
+    * \brief Set the symbol of a numbered node that has no symbol yet.
+    *
+    * Called for the symbols added after the snapshot was built, so that each node keeps its first symbol.
+    */
+   void addSymbol( ExpressionGraph::Node* node, const sdo::Symbol& symbol );
+
+   std::size_t size() const {
+      return nodes_.size();
+   }
+
+   ExpressionGraph::Node* getNode( Index index ) const {
+      return nodes_[index];
+   }
+
+   ExpressionGraph::Op getOp( Index index ) const {
+      return ops_[index];
+   }
+
+   ExpressionGraph::Type getType( Index index ) const {
+      return types_[index];
+   }
+
+   Index getChild1( Index index ) const {
+      return child1_[index];
+   }
+
+   Index getChild2( Index index ) const {
+      return child2_[index];
+   }
+
+   Index getChild3( Index index ) const {
+      return child3_[index];
+   }
+
+   /**
+    * \brief Store the indices of the children that the value of a node depends on like get_children().
+    */
+   int getChildren( Index index, Index children[3] ) const {
+      return get_children( ops_[index], child1_[index], child2_[index], child3_[index], children );
+   }
+
+   double getValue( Index index ) const {
+      return values_[index];
+   }
+
+   bool hasSymbol( Index index ) const {
+      return symbols_[index] != NONE;
+   }
+
+   /**
+    * \brief Get the first symbol of a node that has a symbol.
+    */
+   const sdo::Symbol& getSymbol( Index index ) const {
+      return symbolList_[symbols_[index]];
+   }
+
+private:
+   /**
+    * \brief Number the node and its descendants that are not numbered yet and get the index of the node.
+    */
+   Index add( ExpressionGraph::Node* root );
+
+   const NodeSymbols* nodeSymbols_ = nullptr;
+   std::unordered_map<ExpressionGraph::Node*, Index> indices_;
+   std::vector<ExpressionGraph::Node*> nodes_;
+   std::vector<ExpressionGraph::Op> ops_;
+   std::vector<ExpressionGraph::Type> types_;
+   std::vector<Index> child1_;
+   std::vector<Index> child2_;
+   std::vector<Index> child3_;
+   std::vector<double> values_;
+   std::vector<Index> symbols_; //< position of the first symbol of each node in symbolList_ or NONE
+   std::vector<sdo::Symbol> symbolList_;
+};
+
+}
+
+#endif
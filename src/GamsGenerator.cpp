@@ -1,13 +1,17 @@
 #include <sdo/ButcherTableau.hpp>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <cmath>
 #include <boost/lexical_cast.hpp>
 #include <stack>
+#include <stdexcept>
 #include "SetIndex.hpp"
 #include "GamsGenerator.hpp"
 #include "Escape.hpp"
+#include "NodeChildren.hpp"
+#include "OutputBuffer.hpp"
 
 using namespace sdo;
 
@@ -24,28 +28,50 @@ static bool has_spline_type( const std::unordered_map<LookupTable*, gams::Lookup
    return std::any_of( lkpData.begin(), lkpData.end(), cond );
 }
 
-
-static bool has_sos2_type( const std::unordered_map<LookupTable*, gams::LookupData>& lkpData )
+/**
+ * Reserve the identifiers that the generated model declares besides the symbols.
+ */
+static void reserve_generated_names( gams::NameTable& names )
 {
-   return std::any_of(
-             lkpData.begin(),
-             lkpData.end(),
-             []( const LkpTypePair & val )
-               {
-                  return val.second.type == gams::LookupFormulationType::SOS2;
-               }
-   );
+   typedef gams::NameTable::Pattern Pattern;
+
+   for( const char* name : { "objective", "s", "tp", "tfirst", "tlast", "coeff", "weight", "fi", "fj", "m",
+                             "TIME", "EPSILON", "SMOOTHING", "Lookup" } )
+      names.reserve( name );
+
+   //the sets and their aliases, which repeat the name of the set
+   for( int set = 0; set < gams::SET_COUNT; ++set )
+   {
+      std::string setName = gams::get_set_name( gams::SetId( set ) );
+      names.reserve( setName );
+      names.reserve( setName, Pattern::REPEATED );
+   }
+
+   //the sets of the control steps, the quotients, the big-M formulations and the folded equations
+   for( const char* prefix : { "t", "quot", "bigm", "fold", "v_fold", "c_fold", "m_fold" } )
+      names.reserve( prefix, Pattern::NUMBERED );
+
+   //the equations and the data of the lookups
+   for( const char* prefix : { "eq_", "lkp_" } )
+      names.reserve( prefix, Pattern::PREFIX );
 }
 
 
 namespace gams
 {
 
+void GamsGenerator::addSymbol( const Symbol& symbol, ExpressionGraph::Node* node )
+{
+   symbols_[symbol] = node;
+   nodeSymbols_.emplace( node, symbol );
+   flat_.addSymbol( node, symbol );
+}
+
 void GamsGenerator::setLookupFormulationTypes( LookupFormulationType type )
 {
    std::unordered_map<LookupTable*, LookupData> lkpData;
 
-   for( auto & entry : exprGraph_.getSymbolTable() )
+   for( auto & entry : getSymbolTable() )
    {
       if( entry.second->op == ExpressionGraph::LOOKUP_TABLE )
       {
@@ -69,7 +95,7 @@ void GamsGenerator::createStateSymbols()
 {
    std::unordered_map<ExpressionGraph::Node*, Symbol> newSymbols;
 
-   for( auto & entry : exprGraph_.getSymbolTable() )
+   for( auto & entry : getSymbolTable() )
    {
       std::stack<std::pair<int, ExpressionGraph::Node*>> stack;
       stack.emplace( 0, entry.second );
@@ -81,7 +107,8 @@ void GamsGenerator::createStateSymbols()
       {
          std::pair<int, ExpressionGraph::Node*> top = stack.top();
          stack.pop();
-         auto range = exprGraph_.getSymbol( top.second );
+         countVisit();
+         auto range = getSymbol( top.second );
 
          if( !start && !range.empty() )
             continue;
@@ -179,111 +206,255 @@ void GamsGenerator::createStateSymbols()
 
    for( auto & entry : newSymbols )
    {
-      exprGraph_.addSymbol( entry.second, entry.first );
+      addSymbol( entry.second, entry.first );
    }
 }
 
-void GamsGenerator::controlSet( std::string set )
+void GamsGenerator::setScenarios( ScenarioTable scenarios )
 {
-   auto& s = sets_[set];
-   s.second = std::max( ++s.first, s.second );
-}
+   for( const Symbol& constant : scenarios.constants )
+   {
+      ExpressionGraph::Node* node = getNode( constant );
 
-void GamsGenerator::releaseSet( std::string set )
-{
-   auto& s = sets_[set];
-   --s.first;
+      if( !node || node->type != ExpressionGraph::CONSTANT_NODE )
+         throw std::runtime_error( "scenario parameter '" + constant.get() + "' is not a constant of the model" );
+   }
+
+   scenarios_ = std::move( scenarios );
+   analyzeScenarioDependencies();
 }
 
-void GamsGenerator::createSet( std::string set )
+void GamsGenerator::analyzeScenarioDependencies()
 {
-   sets_.emplace( set, std::make_pair( 0, 0 ) );
-}
+   scenarioNodes_.clear();
 
+   if( scenarios_.empty() )
+      return;
 
+   //collect the parents of all nodes
+   std::unordered_map<ExpressionGraph::Node*, std::vector<ExpressionGraph::Node*>> parents;
+   std::unordered_set<ExpressionGraph::Node*> nodes;
+   std::stack<ExpressionGraph::Node*> stack;
 
-std::string GamsGenerator::getSets( std::initializer_list< SetIndex > list ) const
-{
-   std::ostringstream stringstream;
-   bool start = true;
+   for( auto & entry : getSymbolTable() )
+   {
+      stack.push( entry.second );
+   }
 
-   for( const SetIndex & idx : list )
+   while( !stack.empty() )
    {
-      if( !start )
-      {
-         stringstream << ", ";
-      }
+      ExpressionGraph::Node* top = stack.top();
+      stack.pop();
+
+      if( !nodes.emplace( top ).second )
+         continue;
 
-      start = false;
+      if( top->op == ExpressionGraph::CONTROL )
+         scenarioNodes_.emplace( top );
 
-      if( idx.isFirst() )
+      ExpressionGraph::Node* children[3];
+      int n = get_children( top, children );
+
+      for( int i = 0; i < n; ++i )
       {
-         stringstream << "'0'";
+         parents[children[i]].push_back( top );
+         stack.push( children[i] );
       }
-      else
-      {
-         auto iter = sets_.find( idx.getName() );
-         assert( iter != sets_.end() );
-         stringstream << idx.getName();
+   }
 
-         for( int i = 0; i < iter->second.first; ++i )
-         {
-            stringstream << idx.getName();
-         }
+   for( const Symbol& constant : scenarios_.constants )
+   {
+      scenarioNodes_.emplace( getNode( constant ) );
+   }
+
+   //every node that depends on a scenario node is a scenario node itself
+   for( ExpressionGraph::Node* node : scenarioNodes_ )
+   {
+      stack.push( node );
+   }
 
-         int offset = idx.getOffset();
+   while( !stack.empty() )
+   {
+      ExpressionGraph::Node* top = stack.top();
+      stack.pop();
 
-         if( offset > 0 )
-            stringstream << "+" << offset;
-         else if( offset < 0 )
-            stringstream << offset;
+      for( ExpressionGraph::Node* parent : parents[top] )
+      {
+         if( scenarioNodes_.emplace( parent ).second )
+            stack.push( parent );
       }
    }
+}
+
+void GamsGenerator::controlSet( SetId set )
+{
+   SetState& s = sets_[int( set )];
+   s.aliases = std::max( ++s.depth, s.aliases );
+}
+
+void GamsGenerator::releaseSet( SetId set )
+{
+   --sets_[int( set )].depth;
+}
+
+void GamsGenerator::createSet( SetId set )
+{
+   sets_[int( set )].created = true;
+}
 
-   return stringstream.str();
+const std::string& GamsGenerator::getSets( std::initializer_list< SetIndex > list ) const
+{
+   return getSets( list.begin(), list.size() );
 }
 
-std::string GamsGenerator::getInitialSets() const
+const std::string& GamsGenerator::getSets( const SetIndex* indices, std::size_t count ) const
 {
-   if( tableau_.getName() == ButcherTableau::EULER )
+   //each index is packed into 16 bits of the key: a marker bit, the set, its alias depth and its offset
+   assert( count <= 4 );
+   std::uint64_t key = 0;
+
+   for( std::size_t j = 0; j < count; ++j )
    {
-      return getSets( {SetIndex::First( "t" )} );
+      const SetIndex& idx = indices[j];
+      const SetState& s = sets_[int( idx.getSet() )];
+      assert( s.created && s.depth < 64 );
+      assert( idx.isFirst() || ( idx.getOffset() > -128 && idx.getOffset() < 127 ) );
+      std::uint64_t offset = idx.isFirst() ? 0xFF : idx.getOffset() + 128;
+      key = ( key << 16 ) | 0x8000 | ( std::uint64_t( idx.getSet() ) << 14 ) | ( std::uint64_t( s.depth ) << 8 ) | offset;
    }
-   else
+
+   auto found = setStrings_.find( key );
+
+   if( found != setStrings_.end() )
+      return found->second;
+
+   std::string sets;
+
+   for( std::size_t j = 0; j < count; ++j )
    {
-      return getSets( {SetIndex::First( "t" ), SetIndex::First( "p" )} );
+      const SetIndex& idx = indices[j];
+      if( !sets.empty() )
+         sets += ", ";
+
+      if( idx.isFirst() )
+      {
+         sets += "'0'";
+         continue;
+      }
+
+      const char* name = get_set_name( idx.getSet() );
+
+      for( int i = 0; i <= sets_[int( idx.getSet() )].depth; ++i )
+         sets += name;
+
+      int offset = idx.getOffset();
+
+      if( offset > 0 )
+         sets += "+" + std::to_string( offset );
+      else if( offset < 0 )
+         sets += std::to_string( offset );
    }
+
+   return setStrings_.emplace( key, std::move( sets ) ).first->second;
+}
+
+const std::string& GamsGenerator::getInitialSets() const
+{
+   return getSets( initialSets_.data(), indexCount_ );
+}
+
+const std::string& GamsGenerator::getVarSets() const
+{
+   return getSets( varSets_.data(), indexCount_ );
+}
+
+std::string GamsGenerator::getStageCondition() const
+{
+   if( !staged_ )
+      return std::string();
+
+   return "$tp(" + getVarSets() + ")";
 }
 
-std::string GamsGenerator::getVarSets() const
+std::vector<int> GamsGenerator::getUnusedStages() const
 {
-   if( tableau_.getName() == ButcherTableau::EULER )
+   //a stage is used if it has a weight in the integration step or is used by a used stage
+   int n = tableau_.columns();
+   std::vector<bool> used( n, false );
+   std::stack<int> stack;
+
+   for( int j = 0; j < n; ++j )
    {
-      return getSets( { "t" } );
+      if( tableau_[tableau_.rows() - 1][j] != 0. )
+      {
+         used[j] = true;
+         stack.push( j );
+      }
    }
-   else
+
+   while( !stack.empty() )
+   {
+      int i = stack.top();
+      stack.pop();
+
+      for( int j = 0; j < n; ++j )
+      {
+         if( tableau_[i][j] != 0. && !used[j] )
+         {
+            used[j] = true;
+            stack.push( j );
+         }
+      }
+   }
+
+   std::vector<int> unused;
+
+   for( int j = 0; j < n; ++j )
    {
-      return getSets( { "t", "p" } );
+      if( !used[j] )
+         unused.push_back( j + 1 );
    }
+
+   return unused;
+}
+
+std::string GamsGenerator::getScenarioPrefix( ExpressionGraph::Node* node ) const
+{
+   if( isScenarioNode( node ) )
+      return "s, ";
+
+   return std::string();
+}
+
+std::string GamsGenerator::getInitialSets( ExpressionGraph::Node* node ) const
+{
+   return getScenarioPrefix( node ) + getInitialSets();
+}
+
+std::string GamsGenerator::getVarSets( ExpressionGraph::Node* node ) const
+{
+   return getScenarioPrefix( node ) + getVarSets();
 }
 
-void GamsGenerator::createDivisionGuards( std::vector<std::pair<int, std::string>>& varValues )
+void GamsGenerator::createDivisionGuards()
 {
    std::stack<ExpressionGraph::Node*> stack;
    std::unordered_set<ExpressionGraph::Node*> nodes;
 
-   for( auto & entry : exprGraph_.getSymbolTable() )
+   for( auto & entry : getSymbolTable() )
    {
       stack.push( entry.second );
    }
 
    int divisors = 0;
    std::ostringstream ss;
+   quotientIds_.clear();
 
    while( !stack.empty() )
    {
       ExpressionGraph::Node* top = stack.top();
       stack.pop();
+      countVisit();
 
       if( nodes.find( top ) != nodes.end() || top->type != ExpressionGraph::DYNAMIC_NODE )
          continue;
@@ -296,24 +467,37 @@ void GamsGenerator::createDivisionGuards( std::vector<std::pair<int, std::string
       {
          if( top->child2->type == ExpressionGraph::DYNAMIC_NODE )
          {
-            auto   range = exprGraph_.getSymbol( top->child2 );
-            Symbol symb;
+            if( quotients_ )
+               quotientIds_.emplace( top, quotientIds_.size() + 1 );
 
-            if( range.empty() )
-            {
-               ss << "Divisor" << divisors++;
-               symb = ss.str();
-               ss.str( std::string() );
-               exprGraph_.addSymbol( symb, top->child2 );
-            }
-            else
+            //with quotient variables the divisor only needs a guard if it can be zero
+            if( !quotients_ || getBounds( flat_.getIndex( top->child2 ) ).contains( 0. ) )
             {
-               symb = range.begin()->second;
+               auto   range = getSymbol( top->child2 );
+               Symbol symb;
+
+               if( range.empty() )
+               {
+                  //the numbers whose name a symbol already has are skipped
+                  do
+                  {
+                     ss.str( std::string() );
+                     ss << "Divisor" << divisors++;
+                  }
+                  while( getNode( Symbol( ss.str() ) ) || !names_.isAvailable( ss.str() ) );
+
+                  symb = ss.str();
+                  ss.str( std::string() );
+                  addSymbol( symb, top->child2 );
+               }
+               else
+               {
+                  symb = range.begin()->second;
+               }
+
+               divisors_.push_back( top->child2 );
             }
 
-            ss << escape_string(symb) << ".lo(" << getVarSets() << ") = EPSILON;\n";
-            varValues.emplace_back( 0, ss.str() );
-            ss.str( std::string() );
             stack.emplace( top->child2 );
          }
 
@@ -385,7 +569,7 @@ void GamsGenerator::indexSos2Lookups()
    std::stack<ExpressionGraph::Node*> stack;
    std::unordered_set<ExpressionGraph::Node*> nodes;
 
-   for( auto & entry : exprGraph_.getSymbolTable() )
+   for( auto & entry : getSymbolTable() )
    {
       stack.push( entry.second );
    }
@@ -396,6 +580,7 @@ void GamsGenerator::indexSos2Lookups()
    {
       ExpressionGraph::Node* top = stack.top();
       stack.pop();
+      countVisit();
 
       if( nodes.find( top ) != nodes.end() || top->type != ExpressionGraph::DYNAMIC_NODE )
          continue;
@@ -488,22 +673,53 @@ void GamsGenerator::indexSos2Lookups()
 void GamsGenerator::initTableau( ButcherTableau::Name tableau )
 {
    tableau_.setTableau( tableau );
-   createSet( "t" );
 
-   if( tableau != ButcherTableau::EULER )
-      createSet( "p" );
+   if( tableau == ButcherTableau::EULER )
+      initIndexShape<EulerShape>();
+   else
+      initIndexShape<StagedShape>();
+}
+
+template<typename Shape>
+void GamsGenerator::initIndexShape()
+{
+   static_assert( Shape::INDEX_COUNT <= MAX_INDEX_COUNT, "too many indices for the index shape" );
+   auto varSets = Shape::getVarSets();
+   auto initialSets = Shape::getInitialSets();
+   std::copy( varSets.begin(), varSets.end(), varSets_.begin() );
+   std::copy( initialSets.begin(), initialSets.end(), initialSets_.begin() );
+   indexCount_ = Shape::INDEX_COUNT;
+   staged_ = Shape::STAGED;
+
+   for( const SetIndex & idx : varSets )
+      createSet( idx.getSet() );
 }
 
 void GamsGenerator::translateSymbol( std::ostream& stream, Symbol s, bool initial )
 {
-   auto node = exprGraph_.getNode( s );
+   auto node = getNode( s );
+
+   auto folded = foldedMembers_.find( node );
+
+   if( folded != foldedMembers_.end() )
+   {
+      translateFamilyMember( stream, folded->second.first, "'" + std::to_string( folded->second.second + 1 ) + "'", initial );
+      return;
+   }
 
-   std::string varName = escape_string( s );
+   const std::string& varName = names_.getName( s );
+   std::string scenario = getScenarioPrefix( node );
+   //the reported symbols are computed from the levels of the variables
+   std::string level = reportContext_ && isLive( node ) ? ".l" : "";
 
    switch( node->type )
    {
    case ExpressionGraph::CONSTANT_NODE:
       stream << varName;
+
+      if( isScenarioNode( node ) )
+         stream << "(s)";
+
       break;
 
    case ExpressionGraph::DYNAMIC_NODE:
@@ -512,31 +728,35 @@ void GamsGenerator::translateSymbol( std::ostream& stream, Symbol s, bool initia
          switch( node->control_size )
          {
          case 0:
-            stream << varName;
+            stream << varName << level;
+
+            if( isScenarioNode( node ) )
+               stream << "(s)";
+
             break;
 
          case 1:
-            stream << varName;
+            stream << varName << level;
 
             if( initial )
-               stream << "(" << getSets( {SetIndex::First( "t" ) } ) << ")";
+               stream << "(" << scenario << getSets( {SetIndex::First( SetId::T ) } ) << ")";
             else
-               stream << "(" << getSets( {"t"} ) <<  ")";
+               stream << "(" << scenario << getSets( { SetId::T } ) <<  ")";
 
             break;
 
          default:
             if( initial )
             {
-               stream << "('0')";
+               stream << "(" << scenario << "'0')";
             }
             else
             {
-               std::string t = getSets( {"t"} );
+               std::string t = getSets( { SetId::T } );
                std::string csize = boost::lexical_cast<std::string>( node->control_size );
                stream << "sum(t" << csize << "$(ord(" << t << ") > (ord(t" << csize << ")-1)*" << csize
                       << " and ord(" << t << ") <= ord(t" << csize << ")*" << csize << "),"
-                      << varName << "(t" << csize << "))";
+                      << varName << level << "(" << scenario << "t" << csize << "))";
             }
          }
       }
@@ -548,19 +768,21 @@ void GamsGenerator::translateSymbol( std::ostream& stream, Symbol s, bool initia
 
             if( node->init == ExpressionGraph::CONSTANT_INIT )
                stream << ".lo";
+            else
+               stream << level;
 
-            stream << "(" << getInitialSets() << ")";
+            stream << "(" << getInitialSets( node ) << ")";
          }
          else
          {
-            stream << varName << "(" << getVarSets() << ")";
+            stream << varName << level << "(" << getVarSets( node ) << ")";
          }
       }
 
       break;
 
    case ExpressionGraph::STATIC_NODE:
-      stream << varName << "(" << getSets( {"t"} ) << ")";
+      stream << varName << "(" << scenario << getSets( { SetId::T } ) << ")";
       break;
 
    case ExpressionGraph::UNKNOWN:
@@ -569,52 +791,177 @@ void GamsGenerator::translateSymbol( std::ostream& stream, Symbol s, bool initia
 
 }
 
+void GamsGenerator::translateSymbolReference( std::ostream& stream, FlatGraph::Index index, bool initial )
+{
+   //the text depends on the node, the alias depths and the flags
+   std::uint32_t variant = 0;
+
+   for( const SetState& s : sets_ )
+      variant = ( variant << 6 ) | s.depth;
+
+   variant = ( variant << 2 ) | ( std::uint32_t( reportContext_ ) << 1 ) | initial;
+
+   //nodes may be added to the snapshot during the translation
+   if( firstSymbolTexts_.size() < flat_.size() )
+      firstSymbolTexts_.resize( flat_.size(), -1 );
+
+   int position = firstSymbolTexts_[index];
+
+   while( position != -1 && symbolTexts_[position].variant != variant )
+      position = symbolTexts_[position].next;
+
+   if( position == -1 )
+   {
+      ++symbolMisses_;
+      translateSymbol( symbolArena_, flat_.getSymbol( index ), initial );
+      position = symbolTexts_.size();
+      symbolTexts_.push_back( SymbolText { variant, firstSymbolTexts_[index], symbolArena_.take() } );
+      firstSymbolTexts_[index] = position;
+   }
+   else
+   {
+      ++symbolHits_;
+   }
+
+   const OutputFragment& text = symbolTexts_[position].text;
+   stream.write( text.data, text.size );
+}
+
 void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root, bool def, bool initial )
 {
-   std::stack<std::pair<int, ExpressionGraph::Node*>> stack;
-   stack.emplace( 0, root );
+   std::stack<std::pair<int, FlatGraph::Index>> stack;
+   stack.emplace( 0, flat_.getIndex( root ) );
 
    do
    {
-      std::pair<int, ExpressionGraph::Node*>& top = stack.top();
-      ExpressionGraph::Node* node = top.second;
+      std::pair<int, FlatGraph::Index>& top = stack.top();
+      FlatGraph::Index index = top.second;
+      ExpressionGraph::Node* node = flat_.getNode( index );
+      ExpressionGraph::Op op = flat_.getOp( index );
+      ExpressionGraph::Type type = flat_.getType( index );
+      countVisit();
 
       // if not translating a definition or not the root node of a definition
       // emit the symbol of a node if it exists
       if( !def || (def && node != root) )
       {
-         auto range = exprGraph_.getSymbol( node );
+         //leaves that differ between the members of a folded family are replaced
+         if( foldContext_ )
+         {
+            //constants are the same in initial translation
+            const auto& leaves = foldContext_->leaves[initial && type != ExpressionGraph::CONSTANT_NODE];
+            auto leaf = leaves.find( node );
+
+            if( leaf != leaves.end() )
+            {
+               translateFoldedLeaf( stream, leaf->second, initial );
+               stack.pop();
+               continue;
+            }
+         }
+
+         //the initial value of a symbol that differs between the scenarios is not known,
+         //so its definition is expanded unless it is a state, a control or a constant
+         bool expand = initial && isScenarioNode( node ) && op != ExpressionGraph::INTEG
+                       && op != ExpressionGraph::CONTROL && type != ExpressionGraph::CONSTANT_NODE;
 
-         if( !range.empty() )
+         if( flat_.hasSymbol( index ) && !expand )
          {
             //symbol exists
-            //for initial translation translate symbol only if it is a state, else use its initial value
-            if ( !initial || ( initial && node->op == ExpressionGraph::INTEG ))
-               translateSymbol(stream, range.begin()->second, initial );
+            //for initial translation translate symbol only if it is a state or a scenario parameter, else use its initial value
+            if ( !initial || ( initial && op == ExpressionGraph::INTEG )
+                  || ( isScenarioNode( node ) && type == ExpressionGraph::CONSTANT_NODE ) )
+               translateSymbolReference( stream, index, initial );
             else
-               stream << boost::lexical_cast<std::string>(node->value);
+               stream << number( flat_.getValue( index ) );
+            stack.pop();
+            continue;
+         }
+      }
+
+      const char* pattern = nullptr;
+
+      //nonsmooth operators applied to variables are reformulated
+      if( !initial && !reportContext_ && type == ExpressionGraph::DYNAMIC_NODE )
+      {
+         auto bigm = bigmIds_.find( node );
+
+         if( bigm != bigmIds_.end() )
+         {
+            translateBigM( stream, node, bigm->second );
+            stack.pop();
+            continue;
+         }
+
+         auto quotient = quotientIds_.find( node );
+
+         if( quotient != quotientIds_.end() )
+         {
+            stream << "quot" << quotient->second << "(" << getVarSets( node ) << ")";
+            stack.pop();
+            continue;
+         }
+
+         pattern = getSmoothPattern( op );
+      }
+
+      //operators with literal operands are simplified
+      std::string simplified;
+
+      if( !pattern )
+      {
+         if( ExpressionGraph::Node* operand = getSimplifiedOperand( node, initial ) )
+         {
             stack.pop();
+            stack.emplace( 0, flat_.getIndex( operand ) );
             continue;
          }
+
+         simplified = getSimplifiedPattern( node, initial );
+
+         if( !simplified.empty() )
+            pattern = simplified.c_str();
       }
 
-      switch( node->op )
+      if( pattern )
+      {
+         //top.first is the position in the pattern after the last emitted child
+         const char* pos = pattern + top.first;
+
+         while( *pos && *pos != '\1' && *pos != '\2' )
+            stream << *pos++;
+
+         if( !*pos )
+         {
+            stack.pop();
+            continue;
+         }
+
+         top.first = pos - pattern + 1;
+         stack.emplace( 0, *pos == '\1' ? flat_.getChild1( index ) : flat_.getChild2( index ) );
+         continue;
+      }
+
+      switch( op )
       {
       case ExpressionGraph::INTEG:
          stack.pop();
          if(initial)
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
          else
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
          continue;
 
       case ExpressionGraph::TIME:
-         stream << "TIME(" << getSets( { "t" } ) << ")";
+         if( initial )
+            stream << "TIME(" << getSets( { SetIndex::First( SetId::T ) } ) << ")";
+         else
+            stream << "TIME(" << getSets( { SetId::T } ) << ")";
          stack.pop();
          continue;
 
       case ExpressionGraph::CONSTANT:
-         stream << boost::lexical_cast<std::string>( node->value );
+         stream << number( flat_.getValue( index ) );
          stack.pop();
          continue;
 
@@ -624,25 +971,25 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << ")*(";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
             stream << ")+(1-(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 3:
             stream << "))*(";
             ++top.first;
-            stack.emplace( 0, node->child3 );
+            stack.emplace( 0, flat_.getChild3( index ) );
             continue;
 
          case 4:
@@ -655,9 +1002,9 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          stack.pop();
 
          if( initial )
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
          else
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
 
          continue;
 
@@ -665,21 +1012,21 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          switch( top.first )
          {
          case 0:
-            stream << "( (TIME(" << getSets( { "t" } ) << ")+TIMESTEP/2) > ";
+            stream << "( (TIME(" << getSets( { SetId::T } ) << ")+TIMESTEP/2) > ";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
-            stream << " and (TIME(" << getSets( { "t" } ) << ")+TIMESTEP/2) < (";
+            stream << " and (TIME(" << getSets( { SetId::T } ) << ")+TIMESTEP/2) < (";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 2:
             stream << "+";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 3:
@@ -692,39 +1039,39 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          switch( top.first )
          {
          case 0:
-            stream << "(mod(TIME(" << getSets( { "t" } ) << "), ";
+            stream << "(mod(TIME(" << getSets( { SetId::T } ) << "), ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 1:
             stream << ")+TIMESTEP/2) > ";
             ++top.first;
-            stack.emplace( 0, node->child1->child1 );
+            stack.emplace( 0, flat_.getChild1( flat_.getChild1( index ) ) );
             continue;
 
          case 2:
-            stream << " and (mod(TIME(" << getSets( { "t" } ) << "), ";
+            stream << " and (mod(TIME(" << getSets( { SetId::T } ) << "), ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 3:
             stream << ")+TIMESTEP/2) < (";
             ++top.first;
-            stack.emplace( 0, node->child1->child1 );
+            stack.emplace( 0, flat_.getChild1( flat_.getChild1( index ) ) );
             continue;
 
          case 4:
             stream << "+";
             ++top.first;
-            stack.emplace( 0, node->child1->child2 );
+            stack.emplace( 0, flat_.getChild2( flat_.getChild1( index ) ) );
             continue;
 
          case 5:
-            stream << ") and ( TIME(" << getSets( { "t" } ) << ")+TIMESTEP/2 < ";
+            stream << ") and ( TIME(" << getSets( { SetId::T } ) << ")+TIMESTEP/2 < ";
             ++top.first;
-            stack.emplace( 0, node->child3 );
+            stack.emplace( 0, flat_.getChild3( index ) );
             continue;
 
          case 6:
@@ -738,15 +1085,15 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          switch( top.first )
          {
          case 0:
-            stream << "(TIME(" << getSets( {"t"} ) << ")+TIMESTEP/2 > ";
+            stream << "(TIME(" << getSets( { SetId::T } ) << ")+TIMESTEP/2 > ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 1:
             stream << ")*(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 2:
@@ -761,25 +1108,25 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
-            stream << " * ( min(TIME(" << getSets( {"t"} ) << "),";
+            stream << " * ( min(TIME(" << getSets( { SetId::T } ) << "),";
             ++top.first;
-            stack.emplace( 0, node->child3 );
+            stack.emplace( 0, flat_.getChild3( index ) );
             continue;
 
          case 2:
             stream << ") - ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 3:
-            stream << "))$(TIME(" << getSets( {"t"} ) << ") > ";
+            stream << "))$(TIME(" << getSets( { SetId::T } ) << ") > ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 4:
@@ -801,7 +1148,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "abs(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -816,7 +1163,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "sin(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -831,7 +1178,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "cos(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -846,7 +1193,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "tan(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -861,7 +1208,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "arcsin(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -876,7 +1223,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "arccos(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -891,7 +1238,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "arctan(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -906,7 +1253,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "sinh(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -921,7 +1268,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "cosh(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -936,7 +1283,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "tanh(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -951,7 +1298,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "exp(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -966,7 +1313,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "floor(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -981,7 +1328,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "log(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -996,7 +1343,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "-(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -1011,7 +1358,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "not (";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -1026,7 +1373,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "sqrt(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -1040,13 +1387,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          {
          case 0:
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << "+";
             stack.pop();
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
          }
 
@@ -1055,13 +1402,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          {
          case 0:
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << "-(";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1076,13 +1423,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << ")*(";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1097,13 +1444,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << ")/(";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1118,13 +1465,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << " and ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1139,13 +1486,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << " or ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1160,13 +1507,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << " < ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1181,13 +1528,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << " <= ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1202,13 +1549,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << " > ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1223,13 +1570,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << " >= ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1244,13 +1591,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << " eq ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1265,13 +1612,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << " <> ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1286,13 +1633,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "log(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << ")/log(";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1307,13 +1654,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << ")**(";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1328,13 +1675,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "min(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << ", ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1349,13 +1696,13 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          case 0:
             stream << "max(";
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
             stream << ", ";
             ++top.first;
-            stack.emplace( 0, node->child2 );
+            stack.emplace( 0, flat_.getChild2( index ) );
             continue;
 
          case 2:
@@ -1370,12 +1717,12 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
             case 0:
                stream << "mod(";
                ++top.first;
-               stack.emplace( 0, node->child1 );
+               stack.emplace( 0, flat_.getChild1( index ) );
                continue;
             case 1:
                stream << ", ";
                ++top.first;
-               stack.emplace( 0, node->child2 );
+               stack.emplace( 0, flat_.getChild2( index ) );
                continue;
             case 2:
                stream << ")";
@@ -1397,7 +1744,7 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
                initial = true;
             }
 
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
 
          case 1:
@@ -1413,7 +1760,35 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
 
          if( initial )
          {
-            stream << boost::lexical_cast<std::string>( node->child1->lookup_table->operator()( node->child2->value ) );
+            //the initial value of the argument is only known if it is the same in all scenarios
+            if( !isScenarioNode( node->child2 ) )
+            {
+               stream << number( node->child1->lookup_table->operator()( flat_.getValue( flat_.getChild2( index ) ) ) );
+               stack.pop();
+               continue;
+            }
+
+            OutputStream argument;
+            translate( argument, node->child2, false, true );
+            std::string x = argument.take().str();
+            const std::string& lkpName = names_.getName( lkpData.name );
+
+            if( lkpData.type == LookupFormulationType::SPLINE )
+            {
+               stream << "Lookup(" << x << ", lkp_" << lkpName << ")";
+            }
+            else
+            {
+               //interpolate between the points of the segment containing the argument
+               std::string p = "lkp_" + lkpName + "_points";
+               std::string xs = "lkp_" + lkpName + "_X";
+               std::string ys = "lkp_" + lkpName + "_Y";
+               stream << "sum(" << p << "$( " << xs << "(" << p << ") <= " << x << " and " << xs << "(" << p << "+1) > " << x << " ), "
+                      << ys << "(" << p << ") + (" << ys << "(" << p << "+1)-" << ys << "(" << p << "))*(" << x << "-" << xs << "(" << p << "))/("
+                      << xs << "(" << p << "+1)-" << xs << "(" << p << ")) )";
+            }
+
+            stack.pop();
             continue;
          }
 
@@ -1425,12 +1800,12 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
             case 0:
                stream << "Lookup(";
                ++top.first;
-               stack.emplace( 0, node->child2 );
+               stack.emplace( 0, flat_.getChild2( index ) );
                continue;
 
             case 1:
                stream << ", lkp_";
-               stream << escape_string( lkpData.name );
+               stream << names_.getName( lkpData.name );
                stream << ")";
                stack.pop();
                continue;
@@ -1438,8 +1813,8 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
          }
          else
          {
-            std::string lkpName  = escape_string(lkpData.name);
-            stream << "sum(lkp_" << lkpName << "_points, lkp_" << lkpName << sos2LkpIds_[node] << "_lambda(" << getVarSets()
+            const std::string& lkpName = names_.getName( lkpData.name );
+            stream << "sum(lkp_" << lkpName << "_points, lkp_" << lkpName << sos2LkpIds_[node] << "_lambda" << ( reportContext_ ? ".l(" : "(" ) << getVarSets( node )
                    << ", lkp_" << lkpName << "_points)*lkp_" << lkpName  << "_Y(lkp_" << lkpName << "_points) )";
             stack.pop();
             continue;
@@ -1448,8 +1823,8 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
 
       case ExpressionGraph::DELAY_FIXED:
       {
-         double timestep = exprGraph_.getNode( Symbol( "TIME STEP" ) )->value;
-         double delaytime = std::min( node->child2->value, timestep );
+         double timestep = getNode( Symbol( "TIME STEP" ) )->value;
+         double delaytime = std::min( flat_.getValue( flat_.getChild2( index ) ), timestep );
          int dt = std::ceil( delaytime / timestep );
 
          switch( top.first )
@@ -1459,32 +1834,32 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
             if( initial )
             {
                stack.pop();
-               stack.emplace( 0, node->child3 );
+               stack.emplace( 0, flat_.getChild3( index ) );
                continue;
             }
 
-            std::string t = getSets( {"t"} );
-            controlSet( "t" );
-            std::string tt = getSets( {"t"} );
+            std::string t = getSets( { SetId::T } );
+            controlSet( SetId::T );
+            std::string tt = getSets( { SetId::T } );
             stream << "sum( " << tt << "$(ord(" << tt << ") eq ord(" << t << ") - " << dt << "), ";
             //input
             ++top.first;
-            stack.emplace( 0, node->child1 );
+            stack.emplace( 0, flat_.getChild1( index ) );
             continue;
          }
 
          case 1:
-            releaseSet( "t" );
+            releaseSet( SetId::T );
             stream << ")+(";
             //initial
             initial = true;
             ++top.first;
-            stack.emplace( 0, node->child3 );
+            stack.emplace( 0, flat_.getChild3( index ) );
             continue;
 
          case 2:
             initial = false;
-            stream << ")$( ord(" << getSets( {"t"} ) << ") le " << dt << " )";
+            stream << ")$( ord(" << getSets( { SetId::T } ) << ") le " << dt << " )";
             stack.pop();
             continue;
          }
@@ -1506,42 +1881,45 @@ void GamsGenerator::translate( std::ostream& stream, ExpressionGraph::Node* root
    while( !stack.empty() );
 }
 
-void GamsGenerator::emitGams( std::ostream& stream )
+void GamsGenerator::emitGams( std::ostream& out )
 {
-   std::vector<std::pair<int, std::string>> parameters;
-   std::vector<std::pair<int, std::string>> varValues;
-   std::vector<std::pair<int, std::string>> equationDeclarations;
-   std::vector<std::pair<int, std::string>> equations;
+   std::vector<std::pair<int, OutputFragment>> parameters;
+   std::vector<std::pair<int, OutputFragment>> varValues;
+   std::vector<std::pair<int, OutputFragment>> equationDeclarations;
+   std::vector<std::pair<int, OutputFragment>> equations;
+   std::vector<OutputFragment> equationScales; //< written after the equations are declared
 
-   auto parameter = [&parameters]( int level, std::ostringstream & ss )
+   auto parameter = [&parameters]( int level, OutputStream & ss )
    {
-      parameters.emplace_back( level, ss.str() );
-      ss.clear();
-      ss.str( std::string() );
+      parameters.emplace_back( level, ss.take() );
    };
 
-   auto varValue = [&varValues]( int level, std::ostringstream & ss )
+   auto varValue = [&varValues]( int level, OutputStream & ss )
    {
-      varValues.emplace_back( level, ss.str() );
-      ss.clear();
-      ss.str( std::string() );
+      varValues.emplace_back( level, ss.take() );
    };
 
-   auto equationDeclaration = [&equationDeclarations]( int level, std::ostringstream & ss )
+   auto equationDeclaration = [&equationDeclarations]( int level, OutputStream & ss )
    {
-      equationDeclarations.emplace_back( level, ss.str() );
-      ss.clear();
-      ss.str( std::string() );
+      equationDeclarations.emplace_back( level, ss.take() );
    };
 
-   auto equation = [&equations]( int level, std::ostringstream & ss )
+   auto equation = [&equations]( int level, OutputStream & ss )
    {
-      equations.emplace_back( level, ss.str() );
-      ss.clear();
-      ss.str( std::string() );
+      equations.emplace_back( level, ss.take() );
    };
 
-   std::ostringstream ss;
+   //the statements are written in the order they are generated to stream and the
+   //fragments of ss are sorted by their level before they are written after them
+   OutputStream stream;
+   OutputStream ss;
+   OutputStream declarations;
+   OutputStream scales;
+   std::string stage = getStageCondition();
+   //the phases are measured until the end of the function if profiling is enabled
+   Profile::Phase phase( profile_, "emitLookupsAndSets" );
+   reserve_generated_names( names_ );
+   names_.addSymbols( getSymbolTable() );
 
    stream << "$offdigit\n";
 
@@ -1563,7 +1941,7 @@ void GamsGenerator::emitGams( std::ostream& stream )
    //handle lookups
    for( LkpTypePair & pair : lkpData_ )
    {
-      std::string lkp_name = escape_string( pair.second.name );
+      const std::string& lkp_name = names_.getName( pair.second.name );
 
       //stream lookup data into lookups.dat and count lin
       if( pair.second.type == LookupFormulationType::SPLINE )
@@ -1579,8 +1957,8 @@ void GamsGenerator::emitGams( std::ostream& stream )
             space = true;
             double x = point.get<0>();
             double y = point.get<1>();
-            stream << boost::lexical_cast<std::string>( x ) << " "
-                   << boost::lexical_cast<std::string>( y );
+            stream << number( x ) << " "
+                   << number( y );
          }
 
          stream << "\n";
@@ -1592,25 +1970,25 @@ void GamsGenerator::emitGams( std::ostream& stream )
       {
          ss << "Parameter lkp_" << lkp_name << "_X(lkp_" << lkp_name << "_points) /";
          int i = 1;
-         ss << "\n\t" << i++ << "\t-" << boost::lexical_cast<std::string>( lkp_infty_ );
+         ss << "\n\t" << i++ << "\t-" << number( lkp_infty_ );
 
          for( double xval : pair.first->getXvals() )
          {
-            ss << "\n\t" << i++ << "\t" << boost::lexical_cast<std::string>( xval );
+            ss << "\n\t" << i++ << "\t" << number( xval );
          }
 
-         ss << "\n\t" << i++ << "\t" << boost::lexical_cast<std::string>( lkp_infty_ );
+         ss << "\n\t" << i++ << "\t" << number( lkp_infty_ );
          ss << " /;\n";
          ss << "Parameter lkp_" << lkp_name << "_Y(lkp_" << lkp_name << "_points) /";
          i = 1;
-         ss << "\n\t" << i++ << "\t" << boost::lexical_cast<std::string>( pair.first->getYvals().front() );
+         ss << "\n\t" << i++ << "\t" << number( pair.first->getYvals().front() );
 
          for( double yval : pair.first->getYvals() )
          {
-            ss << "\n\t" << i++ << "\t" << boost::lexical_cast<std::string>( yval );
+            ss << "\n\t" << i++ << "\t" << number( yval );
          }
 
-         ss << "\n\t" << i++ << "\t" << boost::lexical_cast<std::string>( pair.first->getYvals().back() );
+         ss << "\n\t" << i++ << "\t" << number( pair.first->getYvals().back() );
          ss << " /;\n";
          parameter( 0, ss );
       }
@@ -1624,17 +2002,18 @@ void GamsGenerator::emitGams( std::ostream& stream )
              << "function Lookup / liblookup.Lookup /;\n\n";
    }
 
-   double final_time = exprGraph_.getNode( Symbol( "FINAL TIME" ) )->value;
-   double initial_time = exprGraph_.getNode( Symbol( "INITIAL TIME" ) )->value;
-   double time_step = exprGraph_.getNode( Symbol( "TIME STEP" ) )->value;
+   double final_time = getNode( Symbol( "FINAL TIME" ) )->value;
+   double initial_time = getNode( Symbol( "INITIAL TIME" ) )->value;
+   double time_step = getNode( Symbol( "TIME STEP" ) )->value;
    //stream sets
    stream << "Set t time periods / " << 0 << "*" << ( final_time - initial_time ) / time_step << " /;\n"
           << "Set tfirst(t) first period;\n"
           << "Set tlast(t) last period;\n\n";
 
-   if( tableau_.getName() != ButcherTableau::EULER )
+   if( staged_ )
    {
       stream << "Set p discretization sampling points / 0*" << tableau_.columns() << " /;\n"
+             << "Set tp(t, p) time periods and discretization points used by the integration;\n"
              << "Table coeff(p, p) discretization coefficients\n";
 
       for( int i = 1; i <= tableau_.columns(); ++i )
@@ -1648,7 +2027,7 @@ void GamsGenerator::emitGams( std::ostream& stream )
 
          for( int j = 1; j <= tableau_.columns(); ++j )
          {
-            stream << "\t" << boost::lexical_cast<std::string>( tableau_[i - 1][j - 1] );
+            stream << "\t" << number( tableau_[i - 1][j - 1] );
          }
 
          stream << "\n";
@@ -1657,16 +2036,38 @@ void GamsGenerator::emitGams( std::ostream& stream )
       stream << "Parameter weight(p) discretization point weights /\n";
 
       for( int i = 1; i <= tableau_.columns(); ++i )
-         stream << "\t" << i << "\t" << boost::lexical_cast<std::string>( tableau_[tableau_.rows() - 1][i - 1] ) << std::endl;
+         stream << "\t" << i << "\t" << number( tableau_[tableau_.rows() - 1][i - 1] ) << std::endl;
 
       stream << "\t/;\n\n";
    }
 
    stream << "tfirst(t) = yes$(ord(t) eq 1);\n"
           << "tlast(t)  = yes$(ord(t) eq card(t));\n";
+
+   if( staged_ )
+   {
+      //the stages of the last time period are not used by an integration step
+      stream << "tp(t, p) = yes$(ord(p) eq 1 or not tlast(t));\n";
+
+      for( int j : getUnusedStages() )
+         stream << "tp(t, '" << j << "') = no;\n";
+   }
+
+   if( !scenarios_.empty() )
+   {
+      stream << "Set s scenarios /";
+
+      for( std::size_t i = 0; i < scenarios_.names.size(); ++i )
+      {
+         stream << ( i == 0 ? " " : ", " ) << escape_string( scenarios_.names[i] );
+      }
+
+      stream << " /;\n";
+   }
+
    std::set<std::size_t> control_step_sizes;
 
-   for( auto & pair : exprGraph_.getSymbolTable() )
+   for( auto & pair : getSymbolTable() )
    {
       if( pair.second->op == ExpressionGraph::CONTROL )
       {
@@ -1689,19 +2090,133 @@ void GamsGenerator::emitGams( std::ostream& stream )
       if( pair.second.type == LookupFormulationType::SOS2 )
       {
          sdo::LookupTable& table = *( pair.first );
-         stream << "set lkp_" << escape_string( pair.second.name ) << "_points / 1*" << table.size() + 2 << " /;\n";
+         stream << "set lkp_" << names_.getName( pair.second.name ) << "_points / 1*" << table.size() + 2 << " /;\n";
       }
    }
 
+   //fill 'flat_', the symbols created below are added to it by addSymbol()
+   phase.next( "flattenGraph" );
+   flat_.build( symbols_, nodeSymbols_ );
+
+   //every node is visited once when it is numbered
+   if( profile_ )
+      profile_->visits += flat_.size();
+
    //create missing symbols
-   createDivisionGuards( varValues );
+   bounds_.clear();
+   boundsKnown_.clear();
+   phase.next( "createDivisionGuards" );
+   createDivisionGuards();
+   phase.next( "createStateSymbols" );
    createStateSymbols();
+   names_.addSymbols( getSymbolTable() );
    //fill map 'sos2LkpIds_'
+   phase.next( "indexSos2Lookups" );
    indexSos2Lookups();
+   //fill 'liveNodes_'
+   phase.next( "analyzeLiveness" );
+   analyzeLiveness();
+   report_.clear();
+   //fill 'blockOf_' and 'loops_'
+   phase.next( "analyzeBlockStructure" );
+   analyzeBlockStructure();
+   //fill 'bigmIds_'
+   phase.next( "indexBigMFormulations" );
+   indexBigMFormulations();
+   //fill 'magnitudes_'
+   phase.next( "estimateMagnitudes" );
+   estimateMagnitudes();
+   //fill 'families_'
+   phase.next( "foldIsomorphicEquations" );
+   foldIsomorphicEquations();
+   phase.next( "translate" );
+   //the kept symbol references depend on the analyses above
+   symbolTexts_.clear();
+   firstSymbolTexts_.assign( flat_.size(), -1 );
+   symbolHits_ = 0;
+   symbolMisses_ = 0;
+
+   if( !families_.empty() )
+   {
+      std::size_t size = 0;
+      bool mapped = false;
+
+      for( const FoldedFamily & family : families_ )
+      {
+         size = std::max( size, family.members.size() );
+         mapped = mapped || !family.maps.empty();
+      }
+
+      stream << "Set fi folded equation indices / 1*" << size << " /;\n";
+
+      if( mapped )
+         stream << "alias(fi, fj);\n";
+
+      for( std::size_t k = 1; k <= families_.size(); ++k )
+      {
+         const FoldedFamily& family = families_[k - 1];
+         stream << "Set fold" << k << "(fi) /";
+
+         for( std::size_t i = 0; i < family.symbols.size(); ++i )
+            stream << ( i == 0 ? "\n\t" : ",\n\t" ) << i + 1 << " \"" << names_.getName( family.symbols[i] ) << '"';
+
+         stream << " /;\n";
+
+         for( std::size_t j = 0; j < family.maps.size(); ++j )
+         {
+            stream << "Set m_fold" << k << "_" << j + 1 << "(fi, fi) /";
+
+            for( std::size_t i = 0; i < family.maps[j].second.size(); ++i )
+               stream << ( i == 0 ? " " : ", " ) << i + 1 << "." << family.maps[j].second[i] + 1;
+
+            stream << " /;\n";
+         }
+
+         for( std::size_t j = 0; j < family.parameters.size(); ++j )
+         {
+            ss << "Parameter c_fold" << k << "_" << j + 1 << "(fi) /";
+
+            for( std::size_t i = 0; i < family.parameters[j].size(); ++i )
+               ss << "\n\t" << i + 1 << "\t" << number( family.parameters[j][i] );
+
+            ss << " /;\n";
+            parameter( 0, ss );
+         }
+      }
+   }
+
+   //mark the algebraic loops within the equations
+   for( const std::vector<ExpressionGraph::Node*>& loop : loops_ )
+   {
+      ss << "* algebraic loop of size " << loop.size() << "\n";
+      equation( getOrderKey( loop.front(), 0 ), ss );
+   }
+
+   //lower bounds for divisors
+   for( ExpressionGraph::Node* divisor : divisors_ )
+   {
+      if( !isLive( divisor ) )
+         continue;
+
+      auto folded = foldedMembers_.find( divisor );
+
+      if( folded == foldedMembers_.end() )
+         ss << names_.getName( getSymbol( divisor ).begin()->second ) << ".lo(" << getVarSets( divisor ) << ") = EPSILON;\n";
+      else
+         ss << "v_fold" << folded->second.first + 1 << ".lo('" << folded->second.second + 1 << "', " << getVarSets() << ") = EPSILON;\n";
+
+      varValue( 0, ss );
+   }
    //create epsilon and time as parameter
    ss << "Parameter EPSILON / 1e-9 /;\n";
    parameter( 0, ss );
 
+   if( std::find( reformulations_.begin(), reformulations_.end(), Reformulation::SMOOTH ) != reformulations_.end() )
+   {
+      ss << "Parameter SMOOTHING / " << number( smoothing_ ) << " /;\n";
+      parameter( 0, ss );
+   }
+
    ss << "Parameter TIME(t);\n"
       << "\tTIME(t) = INITIALTIME+(ord(t)-1)*TIMESTEP;\n";
    parameter( exprGraph_.getTimeNode()->level, ss );
@@ -1709,12 +2224,32 @@ void GamsGenerator::emitGams( std::ostream& stream )
    stream << "\n";
 
    //loop over all symbols. Emit variable declarations directly. Add parameters equations etc. to the corresponding vectors
-   for( auto & entry : exprGraph_.getSymbolTable() )
+   for( auto & entry : getSymbolTable() )
    {
       if(entry.second->op == ExpressionGraph::LOOKUP_TABLE)
          continue;
-      std::string var = escape_string( entry.first );
+      std::string var = names_.getName( entry.first );
+      //prefix of the indices and condition of the equations
+      std::string prefix = getScenarioPrefix( entry.second );
+      std::string domain;
+      int level = entry.second->level;
       std::string comment;
+      auto folded = foldedMembers_.find( entry.second );
+
+      if( folded != foldedMembers_.end() )
+      {
+         //a folded family is emitted for its first member
+         if( folded->second.second != 0 )
+            continue;
+
+         int k = folded->second.first + 1;
+         foldContext_ = &families_[k - 1];
+         var = "v_fold" + std::to_string( k );
+         prefix = "fi, ";
+         domain = "fold" + std::to_string( k ) + "(fi)";
+         level = foldContext_->level;
+      }
+      else
       {
          auto range = exprGraph_.getComments( entry.first );
 
@@ -1726,6 +2261,31 @@ void GamsGenerator::emitGams( std::ostream& stream )
          }
       }
 
+      int order = getOrderKey( entry.second, level );
+
+      if( foldContext_ )
+      {
+         for( ExpressionGraph::Node* member : foldContext_->members )
+            order = std::max( order, getOrderKey( member, level ) );
+      }
+
+      if( !isLive( entry.second ) )
+      {
+         //dead symbols are dropped or computed from the solution after the solve statement
+         if( deadSymbols_ == DeadSymbolHandling::REPORT )
+         {
+            reportContext_ = true;
+            ss << "Parameter " << var << "(" << prefix << getVarSets() << ")" << comment << ";\n";
+            ss << "\t" << var << "(" << prefix << getVarSets() << ")" << stage << " = ";
+            translate( ss, entry.second );
+            ss << ";\n";
+            reportContext_ = false;
+            report_.emplace_back( level, ss.take().str() );
+         }
+
+         continue;
+      }
+
       switch( entry.second->type )
       {
       case ExpressionGraph::DYNAMIC_NODE: //node that depends on time and on states/controls
@@ -1734,136 +2294,162 @@ void GamsGenerator::emitGams( std::ostream& stream )
             switch( entry.second->control_size )
             {
             case 0:
-               stream << "Variable " << var  << comment << ";\n";
+            {
+               std::string index = isScenarioNode( entry.second ) ? "(s)" : "";
+               stream << "Variable " << var << index << comment << ";\n";
 
                if( entry.second->child1 )
                {
-                  ss << var << ".lo = " << boost::lexical_cast<std::string>( entry.second->child1->value ) << ";\n";
+                  ss << var << ".lo" << index << " = " << number( entry.second->child1->value ) << ";\n";
                   varValue( 0, ss );
                }
 
                if( entry.second->child2 )
                {
-                  ss << var << ".l = " << boost::lexical_cast<std::string>( entry.second->child2->value ) << ";\n";
+                  ss << var << ".l" << index << " = " << number( entry.second->child2->value ) << ";\n";
                   varValue( 0, ss );
                }
 
                if( entry.second->child3 )
                {
-                  ss << var << ".up = " << boost::lexical_cast<std::string>( entry.second->child3->value ) << ";\n";
+                  ss << var << ".up" << index << " = " << number( entry.second->child3->value ) << ";\n";
                   varValue( 0, ss );
                }
 
                break;
+            }
 
             case 1:
-               stream << "Variable " << var  << "(t)" << comment << ";\n";
+               stream << "Variable " << var  << "(" << prefix << "t)" << comment << ";\n";
 
                if( entry.second->child1 )
                {
-                  ss << var << ".lo(t) = " << boost::lexical_cast<std::string>( entry.second->child1->value ) << ";\n";
+                  ss << var << ".lo(" << prefix << "t) = " << number( entry.second->child1->value ) << ";\n";
                   varValue( 0, ss );
                }
 
                if( entry.second->child2 )
                {
-                  ss << var << ".l(t) = " << boost::lexical_cast<std::string>( entry.second->child2->value ) << ";\n";
+                  ss << var << ".l(" << prefix << "t) = " << number( entry.second->child2->value ) << ";\n";
                   varValue( 0, ss );
                }
 
                if( entry.second->child3 )
                {
-                  ss << var << ".up(t) = " << boost::lexical_cast<std::string>( entry.second->child3->value ) << ";\n";
+                  ss << var << ".up(" << prefix << "t) = " << number( entry.second->child3->value ) << ";\n";
                   varValue( 0, ss );
                }
 
                break;
 
             default:
-               stream << "Variable " << var  << "(t"  << entry.second->control_size << ")" << comment << ";\n";
+               stream << "Variable " << var  << "(" << prefix << "t"  << entry.second->control_size << ")" << comment << ";\n";
 
                if( entry.second->child1 )
                {
-                  ss << var << ".lo(t" << entry.second->control_size << ") = " << boost::lexical_cast<std::string>( entry.second->child1->value ) << ";\n";
+                  ss << var << ".lo(" << prefix << "t" << entry.second->control_size << ") = " << number( entry.second->child1->value ) << ";\n";
                   varValue( 0, ss );
                }
 
                if( entry.second->child2 )
                {
-                  ss << var << ".l(t" << entry.second->control_size << ") = " << boost::lexical_cast<std::string>( entry.second->child2->value ) << ";\n";
+                  ss << var << ".l(" << prefix << "t" << entry.second->control_size << ") = " << number( entry.second->child2->value ) << ";\n";
                   varValue( 0, ss );
                }
 
                if( entry.second->child3 )
                {
-                  ss << var << ".up(t" << entry.second->control_size << ") = " << boost::lexical_cast<std::string>( entry.second->child3->value ) << ";\n";
+                  ss << var << ".up(" << prefix << "t" << entry.second->control_size << ") = " << number( entry.second->child3->value ) << ";\n";
                   varValue( 0, ss );
                }
             }
          }
          else     //no control -> either state or algebraic
          {
-            stream << "Variable " << var << "(" << getVarSets() << ")" << comment << ";\n";
-            ss << "Equation eq_" << var << "(" << getVarSets() << ");\n";
-            equationDeclaration( entry.second->level, ss );
+            std::string condition = domain.empty() ? "" : "$" + domain;
+            stream << "Variable " << var << "(" << prefix << getVarSets() << ")" << comment << ";\n";
+            ss << "Equation eq_" << var << "(" << prefix << getVarSets() << ");\n";
+            equationDeclaration( order, ss );
 
             if( entry.second->op == ExpressionGraph::INTEG ) //for states create steps for discretization and initial values
             {
-               if( tableau_.getName() == ButcherTableau::EULER )
+               if( !staged_ )
                {
-                  ss << "eq_" << var <<  "(t+1) ..\n\t" << var << "(t+1) =e= "
-                     << var << "(t) + TIMESTEP * ( ";
+                  ss << "eq_" << var <<  "(" << prefix << "t+1)" << condition << " ..\n\t" << var << "(" << prefix << "t+1) =e= "
+                     << var << "(" << prefix << "t) + TIMESTEP * ( ";
                   translate( ss, entry.second->child1, false  );
                   ss << " );\n";
-                  equation( entry.second->level, ss );
+                  equation( order, ss );
                }
                else
                {
                   //declare equation for Integration step which defines the value of state var as
                   //weighted sum of the intermediate time steps according to the butcher tableau
-                  ss << "Equation eq_" << var << "IntegStep(" << getVarSets() << ");\n";
-                  equationDeclaration( entry.second->level, ss );
+                  ss << "Equation eq_" << var << "IntegStep(" << prefix << getVarSets() << ");\n";
+                  equationDeclaration( order, ss );
 
                   //build definition of the integration step
-                  ss << "eq_" << var << "IntegStep(" << getSets( {SetIndex( "t", 1 ), SetIndex::First( "p" )} ) << ") ..\n\t" << var << "(" << getSets( {SetIndex( "t", 1 ), SetIndex::First( "p" )} ) << ") =e= "
-                     << var << "(" << getSets( {"t", SetIndex::First( "p" )} ) << ")+TIMESTEP*sum(p$( ord(p) > 1 ), weight(p)*(";
+                  ss << "eq_" << var << "IntegStep(" << prefix << getSets( {SetIndex( SetId::T, 1 ), SetIndex::First( SetId::P )} ) << ")" << condition << " ..\n\t" << var << "(" << prefix << getSets( {SetIndex( SetId::T, 1 ), SetIndex::First( SetId::P )} ) << ") =e= "
+                     << var << "(" << prefix << getSets( { SetId::T, SetIndex::First( SetId::P ) } ) << ")+TIMESTEP*sum(p$( ord(p) > 1 ), weight(p)*(";
                   translate( ss, entry.second->child1, false );
                   ss << "));\n";
-                  equation( entry.second->level, ss );
+                  equation( order, ss );
                   //define the intermediate steps according to the coefficients in the butcher tableau
 
-                  ss << "eq_" << var << "(" << getVarSets() << ")$( ord(p) > 1 ) ..\n\t" << var << "(" << getVarSets() << ") =e= "
-                     << var << "(" << getSets( {"t", SetIndex::First( "p" )} ) << ")+TIMESTEP*sum(pp$( ord(pp) > 1 ), coeff(p, pp)*(";
-                  controlSet( "p" );
+                  ss << "eq_" << var << "(" << prefix << getVarSets() << ")$( " << ( domain.empty() ? "" : domain + " and " ) << "ord(p) > 1 and tp(t, p) ) ..\n\t" << var << "(" << prefix << getVarSets() << ") =e= "
+                     << var << "(" << prefix << getSets( { SetId::T, SetIndex::First( SetId::P ) } ) << ")+TIMESTEP*sum(pp$( ord(pp) > 1 ), coeff(p, pp)*(";
+                  controlSet( SetId::P );
                   translate( ss, entry.second->child1, false );
                   ss << "));\n";
-                  releaseSet( "p" );
-                  equation( entry.second->level, ss );
+                  releaseSet( SetId::P );
+                  equation( order, ss );
                }
 
                if( entry.second->init == ExpressionGraph::CONSTANT_INIT )
                {
-                  ss << var << ".fx(" << getInitialSets() << ") = ";
+                  ss << var << ".fx(" << prefix << getInitialSets() << ")" << condition << " = ";
                   translate( ss, entry.second->child2, false, true );
                   ss << ";\n";
-                  varValue( entry.second->level, ss );
+                  varValue( level, ss );
                }
                else     //initial value is controled so enforce it by equation
                {
-                  ss << "Equation eq_" << var << "Init;\n";
-                  equationDeclaration( entry.second->level, ss );
-                  ss << "eq_" << var << "Init ..\n\t" << var << "(" << getInitialSets() << ") =e= ";
+                  std::string index = prefix.empty() ? "" : "(" + prefix.substr( 0, prefix.size() - 2 ) + ")";
+                  ss << "Equation eq_" << var << "Init" << index << ";\n";
+                  equationDeclaration( order, ss );
+                  ss << "eq_" << var << "Init" << index << condition << " ..\n\t" << var << "(" << prefix << getInitialSets() << ") =e= ";
                   translate( ss, entry.second->child2, false, true );
                   ss << ";\n";
-                  equation( entry.second->level, ss );
+                  equation( order, ss );
                }
             }
             else      //no integ -> just add definition to equations
             {
-               ss << "eq_" << var << "(" << getVarSets() << ") ..\n\t" << var << "(" << getVarSets() << ") =e= ";
+               //only the stages used by the integration steps are defined
+               if( !stage.empty() )
+                  condition = domain.empty() ? stage : "$( " + domain + " and " + stage.substr( 1 ) + " )";
+
+               ss << "eq_" << var << "(" << prefix << getVarSets() << ")" << condition << " ..\n\t" << var << "(" << prefix << getVarSets() << ") =e= ";
                translate( ss, entry.second );
                ss << ";\n";
-               equation( entry.second->level, ss );
+               equation( order, ss );
+            }
+
+            if( scaling_ )
+            {
+               //the members of a folded family are scaled individually
+               if( foldContext_ )
+               {
+                  for( std::size_t i = 0; i < foldContext_->members.size(); ++i )
+                     emitScales( ss, scales, foldContext_->members[i], var, "'" + std::to_string( i + 1 ) + "', " );
+               }
+               else
+               {
+                  emitScales( ss, scales, entry.second, var, prefix );
+               }
+
+               varValue( 0, ss );
+               equationScales.push_back( scales.take() );
             }
          } //end of case DYNAMIC_NODE
 
@@ -1871,8 +2457,8 @@ void GamsGenerator::emitGams( std::ostream& stream )
 
       case ExpressionGraph::STATIC_NODE:   // node that does depend on time but is constant at each time -> use a parameter
       {
-         ss << "Parameter " << var << "(t)" << comment << ";\n";
-         ss << "\t" << var << "(t) = ";
+         ss << "Parameter " << var << "(" << prefix << "t)" << comment << ";\n";
+         ss << "\t" << var << "(" << prefix << "t) = ";
          translate( ss, entry.second );
          ss << ";\n";
          parameter( entry.second->level, ss );
@@ -1880,32 +2466,121 @@ void GamsGenerator::emitGams( std::ostream& stream )
       }
 
       case ExpressionGraph::CONSTANT_NODE: // constant node -> use a parameter
-         ss << "Parameter " << var << comment << " / " << boost::lexical_cast<std::string>( entry.second->value ) << " /;\n";
+      {
+         auto column = std::find( scenarios_.constants.begin(), scenarios_.constants.end(), entry.first );
+
+         if( column != scenarios_.constants.end() ) // value is given for each prefix
+         {
+            std::size_t j = column - scenarios_.constants.begin();
+            ss << "Parameter " << var << "(s)" << comment << " /";
+
+            for( std::size_t i = 0; i < scenarios_.names.size(); ++i )
+            {
+               ss << "\n\t" << escape_string( scenarios_.names[i] ) << "\t" << number( scenarios_.values[i][j] );
+            }
+
+            ss << " /;\n";
+         }
+         else if( isScenarioNode( entry.second ) ) // value is computed from prefix parameters
+         {
+            ss << "Parameter " << var << "(s)" << comment << ";\n";
+            ss << "\t" << var << "(s) = ";
+            translate( ss, entry.second );
+            ss << ";\n";
+         }
+         else
+         {
+            ss << "Parameter " << var << comment << " / " << number( entry.second->value ) << " /;\n";
+         }
+
          parameter( entry.second->level, ss );
          break;
+      }
 
       case ExpressionGraph::UNKNOWN:
          assert( false );
       }
+
+      foldContext_ = nullptr;
    }
 
    //Add equations and variables for sos2 lookups that were found
    for( std::pair<ExpressionGraph::Node* const, int>& entry : sos2LkpIds_ )
    {
+      if( !isLive( entry.first ) )
+         continue;
+
       LookupData& lkpData = lkpData_[entry.first->child1->lookup_table];
-      std::string lkpName = escape_string(lkpData.name);
-      stream << "sos2 Variable lkp_" << lkpName << entry.second << "_lambda(" << getVarSets() << ", lkp_" << lkpName << "_points);\n";
+      const std::string& lkpName = names_.getName( lkpData.name );
+      std::string sets = getVarSets( entry.first );
+      stream << "sos2 Variable lkp_" << lkpName << entry.second << "_lambda(" << sets << ", lkp_" << lkpName << "_points);\n";
 
-      ss << "Equation eq_lkp_" << lkpName << entry.second  << "_norm(" << getVarSets() << ");\n"
-         << "Equation eq_lkp_" << lkpName << entry.second << "_arg(" << getVarSets() << ");\n";
-      equationDeclaration( entry.first->level, ss );
+      ss << "Equation eq_lkp_" << lkpName << entry.second  << "_norm(" << sets << ");\n"
+         << "Equation eq_lkp_" << lkpName << entry.second << "_arg(" << sets << ");\n";
+      equationDeclaration( getOrderKey( entry.first, entry.first->level ), ss );
 
-      ss << "eq_lkp_" << lkpName << entry.second << "_norm(" << getVarSets() << ") ..\n\t"
-         << "sum(lkp_" << lkpName << "_points, lkp_" << lkpName << entry.second << "_lambda(" << getVarSets() << ", lkp_" << lkpName << "_points)) =e= 1;\n";
-      ss << "eq_lkp_" << lkpName << entry.second << "_arg(" << getVarSets() << ") ..\n\t";
+      ss << "eq_lkp_" << lkpName << entry.second << "_norm(" << sets << ")" << stage << " ..\n\t"
+         << "sum(lkp_" << lkpName << "_points, lkp_" << lkpName << entry.second << "_lambda(" << sets << ", lkp_" << lkpName << "_points)) =e= 1;\n";
+      ss << "eq_lkp_" << lkpName << entry.second << "_arg(" << sets << ")" << stage << " ..\n\t";
       translate( ss, entry.first->child2 );
-      ss << " =e= sum(lkp_" << lkpName << "_points, lkp_" << lkpName << entry.second << "_lambda(" << getVarSets() << ", lkp_" << lkpName << "_points)*lkp_" << lkpName  << "_X(lkp_" << lkpName << "_points) );\n";
-      equation( entry.first->level, ss );
+      ss << " =e= sum(lkp_" << lkpName << "_points, lkp_" << lkpName << entry.second << "_lambda(" << sets << ", lkp_" << lkpName << "_points)*lkp_" << lkpName  << "_X(lkp_" << lkpName << "_points) );\n";
+      equation( getOrderKey( entry.first, entry.first->level ), ss );
+   }
+
+   //Add variables and equations for the big-M formulations of nonsmooth operators
+   std::vector<std::pair<int, ExpressionGraph::Node*>> bigms;
+
+   for( auto & entry : bigmIds_ )
+      bigms.emplace_back( entry.second, entry.first );
+
+   std::sort( bigms.begin(), bigms.end() );
+
+   for( auto & entry : bigms )
+   {
+      createBigMFormulation( entry.second, entry.first, stream, declarations, ss );
+      equation( getOrderKey( entry.second, entry.second->level ), ss );
+      equationDeclaration( getOrderKey( entry.second, entry.second->level ), declarations );
+   }
+
+   //Add variables and equations for the quotients
+   std::vector<std::pair<int, ExpressionGraph::Node*>> quotients;
+
+   for( auto & entry : quotientIds_ )
+   {
+      if( isLive( entry.first ) )
+         quotients.emplace_back( entry.second, entry.first );
+   }
+
+   std::sort( quotients.begin(), quotients.end() );
+
+   for( auto & entry : quotients )
+   {
+      std::string sets = getVarSets( entry.second );
+      std::string var = "quot" + std::to_string( entry.first );
+      Interval bounds = getBounds( flat_.getIndex( entry.second ) );
+      stream << "Variable " << var << "(" << sets << ");\n";
+
+      if( std::isfinite( bounds.lo ) )
+      {
+         ss << var << ".lo(" << sets << ") = " << number( bounds.lo ) << ";\n";
+         varValue( 0, ss );
+      }
+
+      if( std::isfinite( bounds.hi ) )
+      {
+         ss << var << ".up(" << sets << ") = " << number( bounds.hi ) << ";\n";
+         varValue( 0, ss );
+      }
+
+      int order = getOrderKey( entry.second, entry.second->level );
+      ss << "Equation eq_" << var << "(" << sets << ");\n";
+      equationDeclaration( order, ss );
+      ss << "eq_" << var << "(" << sets << ")" << stage << " ..\n\t" << var << "(" << sets << ")*(";
+      translate( ss, entry.second->child2, false );
+      ss << ") =e= ";
+      translate( ss, entry.second->child1, false );
+      ss << ";\n";
+      equation( order, ss );
    }
 
    if(!objective_.empty()) {
@@ -1919,17 +2594,22 @@ void GamsGenerator::emitGams( std::ostream& stream )
       {
          if( !first )
             ss << "+";
-         bool discrSet = sets_.find("p") != sets_.end();
+         bool discrSet = sets_[int( SetId::P )].created;
+         std::string scenario = getScenarioPrefix( getNode( s.variable ) );
          if( s.type == Objective::Summand::MAYER ) {
             if(discrSet)
-               ss << "sum( (t, p)$(ord(p) eq 1 and ord(t) eq card(t)), ";
-            else
+               ss << "sum( (" << scenario << "t, p)$(ord(p) eq 1 and ord(t) eq card(t)), ";
+            else if(scenario.empty())
                ss << "sum( t$(ord(t) eq card(t)), ";
+            else
+               ss << "sum( (" << scenario << "t)$(ord(t) eq card(t)), ";
          } else {
             if(discrSet)
-               ss << "sum( (t, p)$(ord(p) eq 1), ";
-            else
+               ss << "sum( (" << scenario << "t, p)$(ord(p) eq 1), ";
+            else if(scenario.empty())
                ss << "sum( t, ";
+            else
+               ss << "sum( (" << scenario << "t), ";
          }
 
          translateSymbol(ss, s.variable);
@@ -1947,17 +2627,54 @@ void GamsGenerator::emitGams( std::ostream& stream )
    //    'Parameter A(t) = B(t)+5;'
    // is emitted after the definition of B is emitted. If that is not
    // the case gams will complain.
+   phase.next( "sort" );
    std::sort( varValues.begin(), varValues.end() );
    std::sort( equations.begin(), equations.end() );
    std::sort( equationDeclarations.begin(), equationDeclarations.end() );
    std::sort( parameters.begin(), parameters.end() );
+   phase.next( "write" );
+
+   if( profile_ )
+   {
+      const std::pair<const char*, const std::vector<std::pair<int, OutputFragment>>*> sections[] = {
+         { "parameters", &parameters }, { "variable_values", &varValues },
+         { "equation_declarations", &equationDeclarations }, { "equations", &equations }
+      };
+
+      for( auto& section : sections )
+      {
+         for( auto& entry : *section.second )
+            profile_->count( std::string( "bytes." ) + section.first, entry.second.size );
+      }
+
+      for( auto& entry : equations )
+         profile_->maximize( "largest_equation_bytes", entry.second.size );
+
+      profile_->count( "symbols", getSymbolTable().size() );
+      profile_->count( "equations", equations.size() );
+      profile_->count( "symbol_references.copied", symbolHits_ );
+      profile_->count( "symbol_references.built", symbolMisses_ );
+   }
 
+   //the fragments are written in this order without copying them into one string
+   std::vector<OutputFragment> output;
+   output.push_back( stream.take() );
    stream << "\n";
 
-   for( auto & s : sets_ )
+   for( const NameTable::Collision& collision : names_.getCollisions() )
+   {
+      stream << "* '" << collision.symbol << "' is named " << names_.getName( collision.symbol ) << " because ";
+
+      if( collision.other.get().empty() )
+         stream << collision.escaped << " is an identifier of the generated model\n";
+      else
+         stream << "'" << collision.other << "' is also escaped to " << collision.escaped << "\n";
+   }
+
+   for( int set = 0; set < SET_COUNT; ++set )
    {
-      const std::string& setName = s.first;
-      int nAliases = s.second.second;
+      std::string setName = get_set_name( SetId( set ) );
+      int nAliases = sets_[set].aliases;
 
       for( int n = 1; n <= nAliases; ++n )
       {
@@ -1975,49 +2692,97 @@ void GamsGenerator::emitGams( std::ostream& stream )
    //now emit everything that has been generated
    stream << "\n";
 
+   output.push_back( stream.take() );
+
    for( auto & pair : parameters )
-   {
-      stream << pair.second;
-   }
+      output.push_back( pair.second );
 
    stream << "\n";
 
+   output.push_back( stream.take() );
+
    for( auto & pair : varValues )
-   {
-      stream << pair.second;
-   }
+      output.push_back( pair.second );
 
    stream << "\n";
 
+   output.push_back( stream.take() );
+
    for( auto & pair : equationDeclarations )
-   {
-      stream << pair.second;
-   }
+      output.push_back( pair.second );
 
    stream << "\n";
 
-   for( auto & pair : equations )
+   if( blockOrdering_ )
    {
-      stream << pair.second;
+      stream << "* " << blockCount_ << " blocks in block lower triangular order, " << loops_.size() << " algebraic loops\n";
+
+      for( const std::vector<ExpressionGraph::Node*>& loop : loops_ )
+      {
+         stream << "* algebraic loop of size " << loop.size() << ":";
+
+         for( std::size_t i = 0; i < loop.size(); ++i )
+            stream << ( i == 0 ? " " : ", " ) << getBlockVertexName( loop[i] );
+
+         stream << "\n";
+      }
    }
 
+   output.push_back( stream.take() );
+
+   for( auto & pair : equations )
+      output.push_back( pair.second );
+
    stream << "\n";
+   output.push_back( stream.take() );
+   output.insert( output.end(), equationScales.begin(), equationScales.end() );
 
    if(!objective_.empty()) {
+      analyzeModelClass();
+      stream << "* operators applied to variables: "
+             << operatorCounts_[int( Nonlinearity::LINEAR )] << " linear, "
+             << operatorCounts_[int( Nonlinearity::BILINEAR )] << " bilinear, "
+             << operatorCounts_[int( Nonlinearity::QUADRATIC )] << " quadratic, "
+             << operatorCounts_[int( Nonlinearity::NONLINEAR )] << " nonlinear, "
+             << operatorCounts_[int( Nonlinearity::DISCONTINUOUS )] << " discontinuous\n";
       stream << "Model m / all /;\n";
 
+      if( scaling_ )
+         stream << "m.scaleopt = 1;\n";
+
       if(has_spline_type(lkpData_))
          stream << "m.optfile = 1;\n";
       if(objective_.isMinimized())
          stream << "Solve m min objective ";
       else
          stream << "Solve m max objective ";
-      if(has_sos2_type(lkpData_))
-         stream << "using minlp;\n";
+      stream << "using " << getModelType() << ";\n";
+
+   }
+
+   if( deadSymbols_ == DeadSymbolHandling::REPORT )
+   {
+      stream << "\n";
+
+      if( reportInclude_.empty() )
+         emitReport( stream );
       else
-         stream << "using nlp;\n";
+         stream << "$include \"" << reportInclude_ << "\"\n";
+   }
 
+   output.push_back( stream.take() );
+
+   if( profile_ )
+   {
+      std::size_t total = 0;
+
+      for( const OutputFragment& fragment : output )
+         total += fragment.size;
+
+      profile_->count( "bytes.total", total );
    }
+
+   write_fragments( out, output );
 }
 
 void GamsGenerator::addObjective( Objective obj )
@@ -2027,7 +2792,7 @@ void GamsGenerator::addObjective( Objective obj )
 
 void GamsGenerator::addArbitraryObjective()
 {
-   for( auto & entry : exprGraph_.getSymbolTable() )
+   for( auto & entry : getSymbolTable() )
    {
       if( entry.second->op == ExpressionGraph::INTEG )
       {
@@ -5,20 +5,28 @@
 #include <sdo/ButcherTableau.hpp>
 #include <sdo/Objective.hpp>
 #include <sdo/LookupTable.hpp>
+#include <boost/range/iterator_range.hpp>
 #include <unordered_map>
+#include <unordered_set>
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <ostream>
 #include <string>
+#include "Scenarios.hpp"
+#include "Interval.hpp"
+#include "SetIndex.hpp"
+#include "Discretization.hpp"
+#include "Profile.hpp"
+#include "NumberFormat.hpp"
+#include "NameTable.hpp"
+#include "FlatGraph.hpp"
+#include "OutputBuffer.hpp"
 
 
 
 namespace gams {
 
-/**
- * Forward declare class SetIndex.
- */
-class SetIndex;
-
 using namespace sdo;
 
 /**
@@ -29,6 +37,45 @@ enum class LookupFormulationType {
    SOS2 //< This type means, that the GamsGenerator will formulate the lookup in gams using sos2 variables to model the piecewise linear function described by the lookup values.
 };
 
+/**
+ * \brief Nonlinearity of an operator or expression in the variables, ordered from the cheapest to the most expensive class.
+ */
+enum class Nonlinearity {
+   CONSTANT, //< does not depend on any variable
+   LINEAR, //< linear in the variables
+   BILINEAR, //< product of two different linear expressions
+   QUADRATIC, //< quadratic, e.g. the square of a linear expression
+   NONLINEAR, //< smooth general nonlinear function
+   DISCONTINUOUS //< non smooth or discontinuous function like abs, min or comparisons
+};
+
+/**
+ * \brief Classes of nonsmooth operators that can be reformulated.
+ */
+enum class NonsmoothClass {
+   ABS, //< the abs function
+   MINMAX, //< the min and max functions
+   CONDITION //< comparisons and logical operators, that are used in conditions
+};
+
+/**
+ * \brief Enum type to indicate how nonsmooth operators applied to variables are formulated.
+ */
+enum class Reformulation {
+   DIRECT, //< The operator is emitted as it is.
+   SMOOTH, //< The operator is replaced by a smooth approximation.
+   BIGM //< The operator is replaced by binary variables and big-M constraints.
+};
+
+/**
+ * \brief Enum type to indicate what happens to symbols that neither a state nor the objective depends on.
+ */
+enum class DeadSymbolHandling {
+   KEEP, //< Dead symbols are emitted as variables and equations like all other symbols.
+   DROP, //< Dead symbols are not emitted at all.
+   REPORT //< Dead symbols are emitted as parameters that are computed from the levels of the variables after the solve statement.
+};
+
 
 /**
  * \brief Relevant data of a lookup.
@@ -55,6 +102,37 @@ struct LookupData {
 };
 
 
+/**
+ * \brief How a leaf of the definition of a folded equation is replaced.
+ */
+struct FoldedLeaf {
+   enum Kind {
+      PARAMETER, //< constant that differs between the members, replaced by a parameter indexed by the family set
+      REFERENCE, //< symbol of the i-th member of another family for the i-th member of this family
+      MAPPED_REFERENCE //< symbol of some member of another family, given by a map between the family sets
+   };
+
+   Kind kind;
+   int column; //< index of the parameter or map of the family
+   int family; //< the referenced family for references
+};
+
+/**
+ * \brief Structurally identical symbols that are emitted as one indexed variable and equation.
+ * 
+ * The members are indexed by their position in the set 'fold<k>(fi)', where k is the one based index of the family.
+ * Leaves of the definition that differ between the members are replaced as given by the leaves of the
+ * first member's definition.
+ */
+struct FoldedFamily {
+   std::vector<ExpressionGraph::Node*> members; //< nodes of the folded symbols
+   std::vector<Symbol> symbols; //< the folded symbols
+   std::vector<std::vector<double>> parameters; //< parameters[j][i] is the value of the j-th differing constant for member i
+   std::vector<std::pair<int, std::vector<int>>> maps; //< referenced family and the position of the referenced member for each member
+   std::unordered_map<ExpressionGraph::Node*, FoldedLeaf> leaves[2]; //< replaced leaves of the first member, for non initial and initial translation
+   int level = 0; //< maximum level of the members
+};
+
 /**
  * \brief Generates gams from the intermediate represenation of a mdl file.
  * 
@@ -71,6 +149,7 @@ public:
     * \brief Construct a gams generator for a given expression graph.
     * 
     * \param exprGraph the sdo::ExpressionGraph to generate the gams output. It is stored by reference and not copied.
+    *                  The generator does not modify it, so that it can be converted again with other options.
     * \param tableau an enum value of sdo::ButcherTableau::Name to identify the discretization method.
     * \param lkpType the value for the boundaries of the sos2 lookup. The lookup argument should stay in [-lkp_infty,lkp_infty] during optimization.
     */
@@ -78,8 +157,18 @@ public:
       sdo::ExpressionGraph& exprGraph,
       sdo::ButcherTableau::Name tableau = sdo::ButcherTableau::RUNGE_KUTTA_2,
       LookupFormulationType lkpType = LookupFormulationType::SPLINE
-   ) : exprGraph_( exprGraph ), lkp_infty_(1e4)
+   ) : exprGraph_( exprGraph ), symbols_( exprGraph.getSymbolTable() ), lkp_infty_(1e4)
    {
+      //the symbols of each node in the order of the graph
+      for( auto & entry : symbols_ )
+      {
+         if( nodeSymbols_.find( entry.second ) == nodeSymbols_.end() )
+         {
+            for( auto & symbol : exprGraph.getSymbol( entry.second ) )
+               nodeSymbols_.emplace( symbol.first, symbol.second );
+         }
+      }
+
       initTableau(tableau);
       setLookupFormulationTypes(lkpType);
       //create symbols for all states
@@ -88,12 +177,37 @@ public:
       indexSos2Lookups();
    }
 
+   /**
+    * \brief Get the symbols of the graph and the symbols the generator created for unnamed states, lookups and divisors.
+    */
+   const ExpressionGraph::SymbolTable& getSymbolTable() const {
+      return symbols_;
+   }
+
+   /**
+    * \brief Get the symbols of a node in getSymbolTable().
+    */
+   boost::iterator_range<NodeSymbols::const_iterator> getSymbol( ExpressionGraph::Node* node ) const {
+      auto range = nodeSymbols_.equal_range( node );
+      return boost::make_iterator_range( range.first, range.second );
+   }
+
+   /**
+    * \brief Get the node of a symbol in getSymbolTable() or nullptr if there is none.
+    */
+   ExpressionGraph::Node* getNode( const Symbol& symbol ) const {
+      auto found = symbols_.find( symbol );
+      return found == symbols_.end() ? nullptr : found->second;
+   }
+
    /**
     * \brief Generate and emit gams output.
     * 
-    * \param stream the output stream used to emit the generated gams output.
+    * The output is generated into memory and written to the stream at the end.
+    * 
+    * \param out the output stream used to emit the generated gams output.
     */
-   void emitGams( std::ostream& stream );
+   void emitGams( std::ostream& out );
 
    /**
     * \brief Generates an arbritrary objective function containing some state.
@@ -133,24 +247,424 @@ public:
       lkp_infty_ = val;
    }
 
+   /**
+    * \brief Solve the model for several values of some constants at once.
+    * 
+    * Adds the scenario set 's' to the given constants and to all symbols that depend on them.
+    * Since the scenarios are solved independently the controls are also indexed by 's'.
+    * 
+    * \param scenarios the scenario table. All of its constants must be symbols of constant nodes.
+    * \throws std::runtime_error if a constant of the table is not a constant symbol of the model.
+    */
+   void setScenarios( ScenarioTable scenarios );
+
+   /**
+    * \brief Enable folding of structurally identical equations into indexed equations.
+    * 
+    * Symbols whose definitions only differ in the constants and in the members of other folded
+    * families they reference are emitted as a single variable and equation indexed by a new set.
+    * 
+    * \param fold true to enable folding
+    */
+   void setEquationFolding( bool fold ) {
+      foldEquations_ = fold;
+   }
+
+   /**
+    * \brief Enable block lower triangular ordering of the equations.
+    * 
+    * The algebraic equations are emitted in the order of the strongly connected components of
+    * the dependency graph within one time period and algebraic loops are reported as comments.
+    * 
+    * \param order true to enable the ordering
+    */
+   void setBlockOrdering( bool order ) {
+      blockOrdering_ = order;
+   }
+
+   /**
+    * \brief Set the formulation of a class of nonsmooth operators that are applied to variables.
+    * 
+    * \param cls the class of operators
+    * \param reformulation the formulation of the operators
+    */
+   void setReformulation( NonsmoothClass cls, Reformulation reformulation ) {
+      reformulations_[int( cls )] = reformulation;
+   }
+
+   /**
+    * \brief Set the parameter of the smooth approximations.
+    * 
+    * E.g. abs(x) is approximated by sqrt(sqr(x)+eps). Smaller values give better approximations
+    * with larger curvature.
+    * 
+    * \param eps the smoothing parameter
+    */
+   void setSmoothingParameter( double eps ) {
+      smoothing_ = eps;
+   }
+
+   /**
+    * \brief Set the big-M value that is used if no bounds can be derived for the arguments of an operator.
+    * 
+    * \param m the big-M value
+    */
+   void setBigM( double m ) {
+      bigM_ = m;
+   }
+
+   /**
+    * \brief Set the number of significant digits of the numbers in the output.
+    * 
+    * \param digits the number of significant digits or 0 to write the shortest representation
+    *               of each number that reads back as the same double
+    */
+   void setDigits( int digits ) {
+      digits_ = digits;
+   }
+
+   /**
+    * \brief Enable the division free formulation of divisions by variables.
+    * 
+    * Each division a/b is replaced by a variable q with the constraint q*b =e= a. The variable is
+    * bounded by the interval bounds of the quotient if they are finite. The divisor is only
+    * bounded away from zero if its bounds contain zero.
+    * 
+    * \param quotients true to enable the formulation
+    */
+   void setQuotientFormulation( bool quotients ) {
+      quotients_ = quotients;
+   }
+
+   /**
+    * \brief Enable the algebraic simplification of operators with literal constant operands.
+    * 
+    * Identity operations like x*1 or x+0 are removed, double negations are cancelled, integer
+    * powers are emitted as sqr or power and the logarithm of a constant base is precomputed.
+    * 
+    * \param simplify true to enable the simplification
+    */
+   void setSimplification( bool simplify ) {
+      simplify_ = simplify;
+   }
+
+   /**
+    * \brief Enable the scaling of the variables and equations by their estimated magnitudes.
+    * 
+    * The magnitudes are estimated by a forward simulation of the model with the explicit euler method,
+    * the initial values of the controls and the nominal values of the constants. Each variable and its
+    * defining equations are scaled by the power of ten nearest to the largest absolute value.
+    * 
+    * \param scaling true to enable the scaling
+    */
+   void setScaling( bool scaling ) {
+      scaling_ = scaling;
+   }
+
+   /**
+    * \brief Record the phases of emitGams() and the sizes of the emitted sections in a profile.
+    * 
+    * \param profile the profile or nullptr to disable profiling
+    */
+   void setProfile( Profile* profile ) {
+      profile_ = profile;
+   }
+
+   /**
+    * \brief Set how symbols are handled that neither a state nor the objective depends on.
+    * 
+    * \param handling the handling of dead symbols
+    */
+   void setDeadSymbolHandling( DeadSymbolHandling handling ) {
+      deadSymbols_ = handling;
+   }
+
+   /**
+    * \brief Set the name of the file that emitReport() is written to.
+    * 
+    * If the name is set and dead symbols are reported, emitGams() includes the file after the solve statement.
+    * Otherwise the report is emitted directly after the solve statement.
+    * 
+    * \param filename the name of the report file
+    */
+   void setReportInclude( std::string filename ) {
+      reportInclude_ = std::move( filename );
+   }
+
+   /**
+    * \brief Emit the parameters that report the dead symbols after the solve.
+    * 
+    * Must be called after emitGams() if dead symbols are reported and a report include is set.
+    * 
+    * \param stream the output stream used to emit the report.
+    */
+   void emitReport( std::ostream& stream );
+
 private:
    /**
-    * Creates lower bounds slightly above zero for all expressions that are divisors
+    * Marks all nodes that a state or the objective depends on in 'liveNodes_'. In the reporting mode the sos2 lookups
+    * are also kept since the reported symbols are computed from their variables.
+    */
+   void analyzeLiveness();
+
+   /**
+    * \brief Check if the symbol of the node is emitted as variable.
+    * 
+    * Only algebraic symbols can be dead. States, controls and parameters are always live.
+    */
+   bool isLive( ExpressionGraph::Node* node ) const {
+      return deadSymbols_ == DeadSymbolHandling::KEEP || node->type != ExpressionGraph::DYNAMIC_NODE
+             || node->op == ExpressionGraph::INTEG || node->op == ExpressionGraph::CONTROL
+             || isMarkedLive( flat_.findIndex( node ) );
+   }
+
+   /**
+    * \brief Check if the symbol of the node with the given index in 'flat_' is emitted as variable.
+    */
+   bool isLive( FlatGraph::Index index ) const {
+      ExpressionGraph::Op op = flat_.getOp( index );
+      return deadSymbols_ == DeadSymbolHandling::KEEP || flat_.getType( index ) != ExpressionGraph::DYNAMIC_NODE
+             || op == ExpressionGraph::INTEG || op == ExpressionGraph::CONTROL || isMarkedLive( index );
+   }
+
+   /**
+    * \brief Check if the node with the given index in 'flat_' was reached by analyzeLiveness().
+    */
+   bool isMarkedLive( FlatGraph::Index index ) const {
+      return index != FlatGraph::NONE && static_cast<std::size_t>( index ) < liveNodes_.size() && liveNodes_[index];
+   }
+
+   /**
+    * Computes the strongly connected components of the dependency graph between the algebraic variables
+    * within one time period and fills 'blockOf_' and 'loops_'.
+    */
+   void analyzeBlockStructure();
+
+   /**
+    * \brief Check if the node is a vertex of the dependency graph, i.e. an algebraic symbol or an sos2 lookup.
+    */
+   bool isBlockVertex( FlatGraph::Index index ) const;
+
+   /**
+    * \brief Get the vertices that the value of the given vertex depends on in the same time period.
+    * 
+    * \param vertex the index of the vertex in 'flat_'
+    * \param visitedBy the last vertex that visited each node, marks the nodes visited for this vertex
+    */
+   std::vector<FlatGraph::Index> getBlockDependencies( FlatGraph::Index vertex, std::vector<FlatGraph::Index>& visitedBy ) const;
+
+   /**
+    * \brief Get the key that the equations of a node are sorted by.
+    * 
+    * \param node the node defined by the equations
+    * \param level the level of the node, which is the key if the block ordering is disabled
+    */
+   int getOrderKey( ExpressionGraph::Node* node, int level ) const;
+
+   /**
+    * \brief Get the name of the variable of a vertex of the dependency graph.
+    */
+   std::string getBlockVertexName( ExpressionGraph::Node* node );
+
+   /**
+    * Classifies the emitted equations by their nonlinearity. Fills 'operatorCounts_' and 'modelClass_'.
+    */
+   void analyzeModelClass();
+
+   /**
+    * \brief Get the nonlinearity of an expression in the variables and count its operators by their nonlinearity.
+    * 
+    * \param index the index of the node of the expression in 'flat_'
+    * \param initial true if the expression is translated for its initial value
+    * \param root true if the node is translated as a definition, i.e. its symbol is not used
+    */
+   Nonlinearity classify( FlatGraph::Index index, bool initial, bool root );
+
+   /**
+    * \brief Get the cheapest gams model type that is valid for the classified equations.
+    */
+   std::string getModelType() const;
+
+   /**
+    * \brief Get the formulation of the class of the given operator.
+    */
+   Reformulation getReformulation( ExpressionGraph::Op op ) const;
+
+   /**
+    * \brief Check if the operator is replaced by binary variables and big-M constraints.
+    */
+   bool hasBigMFormulation( ExpressionGraph::Op op ) const;
+
+   /**
+    * \brief Get the gams pattern that replaces the operator or a null pointer if it is not replaced.
+    * 
+    * In the pattern the control characters with the codes 1 and 2 are replaced by the translation of the first and second child.
+    */
+   const char* getSmoothPattern( ExpressionGraph::Op op ) const;
+
+   /**
+    * \brief Get the value of a node if it is an unnamed constant that is emitted as a number.
+    * 
+    * \return true if the node is such a literal
+    */
+   bool getLiteral( ExpressionGraph::Node* node, bool initial, double& value ) const;
+
+   /**
+    * \brief Get the operand that replaces the node if it is an identity operation, e.g. x for x*1 or -(-(x)).
+    * 
+    * \return the operand or a null pointer if the node is not simplified
+    */
+   ExpressionGraph::Node* getSimplifiedOperand( ExpressionGraph::Node* node, bool initial ) const;
+
+   /**
+    * \brief Get the gams pattern that replaces the node if it has literal operands, e.g. sqr(x) for x**2.
+    * 
+    * The pattern has the same form as the patterns of getSmoothPattern().
+    * 
+    * \return the pattern or an empty string if the node is not simplified
+    */
+   std::string getSimplifiedPattern( ExpressionGraph::Node* node, bool initial ) const;
+
+   /**
+    * \brief Evaluate a node at the given time.
     * 
-    * \param varValues  vector containing the bounds and fixed values of variables together with their levels.
+    * \param index the index of the node in 'flat_'
+    * \param time the time
+    * \param values values of the nodes by their index in 'flat_'
+    * \param known true for the states and the nodes already evaluated at this time
+    */
+   double evaluate( FlatGraph::Index index, double time, std::vector<double>& values, std::vector<char>& known ) const;
+
+   /**
+    * Simulates the model and stores the largest absolute value of each dynamic symbol in 'magnitudes_'.
     */
-   void createDivisionGuards(std::vector<std::pair<int, std::string>> &varValues);
+   void estimateMagnitudes();
+
+   /**
+    * \brief Get the scale of the variable of the node, which is 1 if the node is not scaled.
+    */
+   double getScale( ExpressionGraph::Node* node ) const;
+
+   /**
+    * \brief Emit the scales of the variable of a node and of its defining equations.
+    * 
+    * The scales of the equations are emitted separately, because they can only be assigned
+    * after the equations are declared.
+    *
+    * \param variables the stream the assignment of the variable scale is emitted to
+    * \param equations the stream the assignments of the equation scales are emitted to
+    * \param node the node
+    * \param var the name of the variable
+    * \param prefix the indices preceding the time and discretization sets
+    */
+   void emitScales( std::ostream& variables, std::ostream& equations, ExpressionGraph::Node* node, const std::string& var, const std::string& prefix );
+
+   /**
+    * Creates an id for each node that is reformulated with big-M constraints and stores it in 'bigmIds_'.
+    */
+   void indexBigMFormulations();
+
+   /**
+    * \brief Get the big-M value for the node from the bounds of its arguments or the default value.
+    */
+   double getBigM( ExpressionGraph::Node* node );
+
+   /**
+    * \brief Get bounds for the value of a node from the bounds of the controls and the values of the constants.
+    * 
+    * States are unbounded. The bounds are cached in 'bounds_'.
+    *
+    * \param index the index of the node in 'flat_'
+    */
+   Interval getBounds( FlatGraph::Index index );
+
+   /**
+    * \brief Emit the variables and equations of the big-M formulation of a node.
+    * 
+    * \param node the reformulated node
+    * \param id the id of the node
+    * \param variables stream for the variable declarations
+    * \param declarations stream for the equation declarations
+    * \param definitions stream for the equation definitions
+    */
+   void createBigMFormulation( ExpressionGraph::Node* node, int id, std::ostream& variables, std::ostream& declarations, std::ostream& definitions );
+
+   /**
+    * \brief Emit the variable of the big-M formulation that represents the value of the node.
+    */
+   void translateBigM( std::ostream& stream, ExpressionGraph::Node* node, int id );
+
+   /**
+    * Creates symbols for all expressions that are divisors and stores them in 'divisors_',
+    * so that their lower bounds can be set slightly above zero. If quotient variables are used
+    * the divisions are stored in 'quotientIds_'.
+    */
+   void createDivisionGuards();
    /**
     * Creates symbols for all states since SMOOTH DELAY etc. may contain hidden states that do not have a symbol in the mdl file.
     */
    void createStateSymbols();
 
+   /**
+    * \brief Add a symbol created by the generator to getSymbolTable() without adding it to the graph.
+    */
+   void addSymbol( const Symbol& symbol, ExpressionGraph::Node* node );
+
    /**
     * Creates an id for each call of an sos2 lookup. The three calls lookup(a+b) lookup(b+a) lookup(c)
     * will get two id's since the first two calls are identical.
     * This avoids the creation of unnecessary sos2 variables.
     */
    void indexSos2Lookups();
+   /**
+    * Marks all nodes whose value differs between the scenarios, i.e. the constants of
+    * the scenario table, the controls and all nodes depending on them.
+    */
+   void analyzeScenarioDependencies();
+
+   /**
+    * \brief Check if the value of the node differs between the scenarios.
+    */
+   bool isScenarioNode( ExpressionGraph::Node* node ) const {
+      return scenarioNodes_.find( node ) != scenarioNodes_.end();
+   }
+
+   /**
+    * Detects families of symbols with isomorphic definitions and fills 'families_' and 'foldedMembers_'.
+    */
+   void foldIsomorphicEquations();
+
+   /**
+    * \brief Computes the structural key of a definition and collects its leaves.
+    * 
+    * Walks the definition in the same way translate() does. Constants and the symbols of other nodes
+    * become leaves and are represented in the key by the index of their first occurrence.
+    * 
+    * \param index the index of the node to walk in 'flat_'
+    * \param initial true if the node is translated for its initial value
+    * \param root true if the node is the root of the definition
+    * \param key the structural key is appended to this string
+    * \param leaves the distinct leaves in order of their first occurrence, with the initial flag they occur with
+    * \return false if the definition contains something that can not be folded
+    */
+   bool getStructuralKey( FlatGraph::Index index, bool initial, bool root, std::string& key,
+                          std::vector<std::pair<ExpressionGraph::Node*, bool>>& leaves );
+
+   /**
+    * \brief Emits the variable of a member of a folded family.
+    * 
+    * \param stream the output stream
+    * \param family zero based index of the family
+    * \param element the element of the set fi identifying the member
+    * \param initial if true the initial value is referenced
+    */
+   void translateFamilyMember( std::ostream& stream, int family, const std::string& element, bool initial );
+
+   /**
+    * \brief Emits the replacement of a leaf in the definition of the folded family 'foldContext_'.
+    */
+   void translateFoldedLeaf( std::ostream& stream, const FoldedLeaf& leaf, bool initial );
+
    /**
     * Initializes the butcher tableau with the given one.
     * 
@@ -158,6 +672,14 @@ private:
     */
    void initTableau(sdo::ButcherTableau::Name tableau);
 
+   /**
+    * \brief Creates the sets of the given index shape and stores its indices for getVarSets() and getInitialSets().
+    *
+    * Called once by initTableau(), so that the index shape is not looked up for every reference.
+    */
+   template<typename Shape>
+   void initIndexShape();
+
    /**
     * \brief Translates a node in the expression graph to gams.
     * 
@@ -190,64 +712,185 @@ private:
     */
    void translateSymbol( std::ostream& stream, Symbol s, bool initial = false );
 
+   /**
+    * \brief Translates the symbol of the node with the given index in the flattened graph as translateSymbol() does.
+    *
+    * The text is kept and copied when the symbol is referenced again with the same alias depths
+    * and flags, so the references within translate() are only built once.
+    */
+   void translateSymbolReference( std::ostream& stream, FlatGraph::Index index, bool initial );
+
    /**
     * \brief Make the set with the given name controled, so that getSets will give an alias string.
     * 
-    * If getSets({{"t", 0}) returns t it will return tt after one call to controlSet("t")
-    * and ttt after two calls to controlSet("t"). Afterwards calling releaseSet("t") will recover
-    * to the state before the last call of controlSet("t").
+    * If getSets({SetId::T}) returns t it will return tt after one call to controlSet(SetId::T)
+    * and ttt after two calls to controlSet(SetId::T). Afterwards calling releaseSet(SetId::T) will recover
+    * to the state before the last call of controlSet(SetId::T).
     * 
-    * \param set the name of the set to control
+    * \param set the set to control
     */
-   void controlSet( std::string set );
+   void controlSet( SetId set );
 
    /**
     * \brief Revert the changes made by controlSet(set)
     * 
-    * \param set the name of the set
+    * \param set the set
     */
-   void releaseSet( std::string set );
+   void releaseSet( SetId set );
 
    /**
     * \brief Create a new set that can then be controled and released by {control, release}Set
     * 
-    * \param set the name of the set
+    * \param set the set
     */
-   void createSet( std::string set );
+   void createSet( SetId set );
 
    /**
     * \brief Get a string representing the sets described by the given initializer list.
     * 
-    * The initializer list contains pairs of set names with offsets. So 
-    * getSets({{"t",1}, "p"}) will return 't+1, p'. If a set is controled
+    * The initializer list contains pairs of sets with offsets. So 
+    * getSets({{SetId::T, 1}, SetId::P}) will return 't+1, p'. If a set is controled
     * before the call to this function an alias will be used instead of the set
     * name. So the string returned for the above example might also be 'tt+1, p'.
     * The first value of a set is assumed to be '0'.
     * 
-    * \param list the sets with their offsets that should be in the string
+    * The strings are built once for each combination of sets, alias depths and offsets
+    * and stay valid as long as the generator.
+    * 
+    * \param list the at most 4 sets with their offsets that should be in the string
     */
-   std::string getSets(std::initializer_list<SetIndex> list) const;
+   const std::string& getSets(std::initializer_list<SetIndex> list) const;
+
+   /**
+    * \brief Get the string representing the given number of set indices.
+    */
+   const std::string& getSets(const SetIndex* indices, std::size_t count) const;
 
    /**
     * \brief Get first set of time and discretization, i.e. "'0'" for euler method or else "'0', '0'".
     */
-   std::string getInitialSets() const;
+   const std::string& getInitialSets() const;
 
    /**
     * \brief Get current time and discretization, i.e. "t" for euler method or else "t, p".
     * 
     * Result can also be the currently controled alias of the sets t and p , e.g. tt or pp.
     */
-   std::string getVarSets() const;
+   const std::string& getVarSets() const;
+
+   /**
+    * \brief Get the string of getInitialSets() prefixed with the scenario set if the node depends on the scenarios.
+    */
+   std::string getInitialSets( ExpressionGraph::Node* node ) const;
+
+   /**
+    * \brief Get the string of getVarSets() prefixed with the scenario set if the node depends on the scenarios.
+    */
+   std::string getVarSets( ExpressionGraph::Node* node ) const;
+
+   /**
+    * \brief Get the condition restricting an equation over getVarSets() to the points used by the integration.
+    * 
+    * The condition is empty for the euler method and "$tp(t, p)" otherwise.
+    */
+   std::string getStageCondition() const;
+
+   /**
+    * \brief Get the double formatted with the number of significant digits set by setDigits().
+    */
+   FormattedDouble number( double value ) const {
+      return FormattedDouble { value, digits_ };
+   }
+
+   /**
+    * \brief Get the labels of the stages of the butcher tableau whose values are never used.
+    */
+   std::vector<int> getUnusedStages() const;
+
+   /**
+    * \brief Get the scenario set followed by a separator if the node depends on the scenarios or else an empty string.
+    */
+   std::string getScenarioPrefix( ExpressionGraph::Node* node ) const;
  
 
    sdo::ButcherTableau tableau_;
    std::unordered_map<LookupTable*, LookupData> lkpData_;
    std::unordered_map<ExpressionGraph::Node*, int> sos2LkpIds_;
+   std::vector<ExpressionGraph::Node*> divisors_;
    sdo::ExpressionGraph& exprGraph_;
+   ExpressionGraph::SymbolTable symbols_; //< the symbols of the graph and the ones created by the generator
+   NodeSymbols nodeSymbols_;
+   NameTable names_; //< identifiers of the symbols, filled by emitGams()
+   FlatGraph flat_; //< snapshot of the graph walked by translate(), filled by emitGams()
+   OutputStream symbolArena_; //< holds the texts of translateSymbolReference()
+   /**
+    * \brief Kept text of a symbol reference.
+    */
+   struct SymbolText {
+      std::uint32_t variant; //< alias depths and flags the text was built with
+      int next; //< position of the next text of the same node in symbolTexts_ or -1
+      OutputFragment text;
+   };
+
+   std::vector<int> firstSymbolTexts_; //< position of the first text of each node of flat_ in symbolTexts_ or -1
+   std::vector<SymbolText> symbolTexts_;
+   std::uint64_t symbolHits_ = 0; //< number of symbol references copied from symbolTexts_
+   std::uint64_t symbolMisses_ = 0;
    sdo::Objective objective_;
    double lkp_infty_;
-   std::unordered_map<std::string, std::pair<int,int>> sets_;
+   /**
+    * \brief State of a set.
+    */
+   struct SetState {
+      bool created = false;
+      int depth = 0; //< number of times the set is currently controled
+      int aliases = 0; //< number of aliases needed, i.e. the maximal depth
+   };
+
+   std::array<SetState, SET_COUNT> sets_;
+   mutable std::unordered_map<std::uint64_t, std::string> setStrings_; //< memoized results of getSets() by their packed key
+   std::array<SetIndex, MAX_INDEX_COUNT> varSets_ = {{ SetId::T, SetId::T }}; //< indices of the variables, set by initIndexShape()
+   std::array<SetIndex, MAX_INDEX_COUNT> initialSets_ = {{ SetId::T, SetId::T }}; //< indices of the initial values, set by initIndexShape()
+   std::size_t indexCount_ = 0; //< number of used entries of varSets_ and initialSets_
+   bool staged_ = false; //< true if the variables are indexed by the stages of the discretization
+   ScenarioTable scenarios_;
+   std::unordered_set<ExpressionGraph::Node*> scenarioNodes_;
+   bool foldEquations_ = false;
+   std::vector<FoldedFamily> families_;
+   std::unordered_map<ExpressionGraph::Node*, std::pair<int, int>> foldedMembers_; //< family and position of folded nodes
+   const FoldedFamily* foldContext_ = nullptr; //< family whose definition is currently translated
+   DeadSymbolHandling deadSymbols_ = DeadSymbolHandling::KEEP;
+   std::vector<char> liveNodes_; //< true for the nodes reached by analyzeLiveness() by their index in 'flat_'
+   std::vector<std::pair<int, std::string>> report_; //< parameters reporting the dead symbols with their level
+   std::string reportInclude_;
+   bool reportContext_ = false; //< true while a reported symbol is translated, so that variables are referenced by their levels
+   bool blockOrdering_ = false;
+   std::vector<int> blockOf_; //< index of the block in order of evaluation of each vertex by its index in 'flat_' or -1
+   std::vector<std::vector<ExpressionGraph::Node*>> loops_; //< blocks with more than one vertex or a vertex depending on itself
+   int blockCount_ = 0;
+   std::array<int, 6> operatorCounts_; //< number of operators applied to variables by their nonlinearity
+   Nonlinearity modelClass_ = Nonlinearity::LINEAR;
+   std::array<Reformulation, 3> reformulations_ {{ Reformulation::DIRECT, Reformulation::DIRECT, Reformulation::DIRECT }};
+   double smoothing_ = 1e-6;
+   double bigM_ = 1e4;
+   int digits_ = 0;
+   std::unordered_map<ExpressionGraph::Node*, int> bigmIds_;
+   std::vector<Interval> bounds_; //< bounds of the nodes by their index in 'flat_'
+   std::vector<char> boundsKnown_; //< true for the nodes whose bounds are in 'bounds_' or being computed
+   bool quotients_ = false;
+   std::unordered_map<ExpressionGraph::Node*, int> quotientIds_;
+   bool simplify_ = true;
+   bool scaling_ = false;
+   std::vector<double> magnitudes_; //< largest absolute value of the dynamic symbols in a simulation by their index in 'flat_' or -1
+   Profile* profile_ = nullptr;
+
+   /**
+    * Count a node visited by a pass over the graph if profiling is enabled.
+    */
+   void countVisit() const {
+      if( profile_ )
+         ++profile_->visits;
+   }
    
 };
 
@@ -0,0 +1,120 @@
+#ifndef _GAMS_INTERVAL_HPP_
+#define _GAMS_INTERVAL_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace gams {
+
+/**
+ * \brief Closed interval of real numbers with infinite bounds for unbounded values.
+ *
+ * Used to derive bounds of expressions from the bounds of the controls and the values
+ * of the constants, e.g. for big-M constants.
+ */
+struct Interval {
+   double lo; //< lower bound, may be -infinity
+   double hi; //< upper bound, may be +infinity
+
+   Interval() : lo( -std::numeric_limits<double>::infinity() ), hi( std::numeric_limits<double>::infinity() ) {}
+   Interval( double val ) : lo( val ), hi( val ) {}
+   Interval( double lo, double hi ) : lo( lo ), hi( hi ) {}
+
+   /**
+    * \brief Check if both bounds are finite.
+    */
+   bool bounded() const {
+      return std::isfinite( lo ) && std::isfinite( hi );
+   }
+
+   /**
+    * \brief Check if the interval contains the given value.
+    */
+   bool contains( double val ) const {
+      return lo <= val && val <= hi;
+   }
+
+   /**
+    * \brief Get the maximum absolute value in the interval.
+    */
+   double magnitude() const {
+      return std::max( std::fabs( lo ), std::fabs( hi ) );
+   }
+};
+
+/**
+ * \brief Product of two bounds where zero times infinity is zero.
+ */
+inline double interval_mult( double a, double b )
+{
+   return a == 0. || b == 0. ? 0. : a * b;
+}
+
+inline Interval operator+( const Interval& a, const Interval& b )
+{
+   return Interval( a.lo + b.lo, a.hi + b.hi );
+}
+
+inline Interval operator-( const Interval& a )
+{
+   return Interval( -a.hi, -a.lo );
+}
+
+inline Interval operator-( const Interval& a, const Interval& b )
+{
+   return a + ( -b );
+}
+
+inline Interval operator*( const Interval& a, const Interval& b )
+{
+   double p[4] = { interval_mult( a.lo, b.lo ), interval_mult( a.lo, b.hi ), interval_mult( a.hi, b.lo ), interval_mult( a.hi, b.hi ) };
+   return Interval( *std::min_element( p, p + 4 ), *std::max_element( p, p + 4 ) );
+}
+
+inline Interval operator/( const Interval& a, const Interval& b )
+{
+   if( b.contains( 0. ) )
+      return Interval();
+
+   return a * Interval( 1. / b.hi, 1. / b.lo );
+}
+
+/**
+ * \brief Hull of two intervals.
+ */
+inline Interval hull( const Interval& a, const Interval& b )
+{
+   return Interval( std::min( a.lo, b.lo ), std::max( a.hi, b.hi ) );
+}
+
+inline Interval abs( const Interval& a )
+{
+   if( a.lo >= 0. )
+      return a;
+
+   if( a.hi <= 0. )
+      return -a;
+
+   return Interval( 0., std::max( -a.lo, a.hi ) );
+}
+
+inline Interval sqr( const Interval& a )
+{
+   Interval b = abs( a );
+   return Interval( b.lo * b.lo, b.hi * b.hi );
+}
+
+inline Interval min( const Interval& a, const Interval& b )
+{
+   return Interval( std::min( a.lo, b.lo ), std::min( a.hi, b.hi ) );
+}
+
+inline Interval max( const Interval& a, const Interval& b )
+{
+   return Interval( std::max( a.lo, b.lo ), std::max( a.hi, b.hi ) );
+}
+
+}
+
+#endif
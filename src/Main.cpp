@@ -2,10 +2,12 @@
 #include <sstream>
 #include <fstream>
 #include <sdo/Parsers.hpp>
-#include <sdo/ButcherTableau.hpp>
-#include "GamsGenerator.hpp"
+#include "Conversion.hpp"
+#include "Batch.hpp"
+#include "Cache.hpp"
+#include "Server.hpp"
+#include "Watch.hpp"
 #include <boost/program_options.hpp>
-#include <boost/algorithm/string/predicate.hpp>
 #include <vector>
 #include <string>
 
@@ -15,12 +17,16 @@ int main( int argc, char const* argv[] )
    po::options_description desc( "Allowed options" );
    desc.add_options()
    ( "help,h", "produce help message" )
-   ( "discretization-method,d", po::value<std::string>()->default_value( "rk2" ), "Method used for discretization. Available: euler, rk2, rk3, rk4, imid2, igl4" )
    ( "input-files", po::value< std::vector<std::string> >(), "Input files" )
    ( "output-file,o", po::value<std::string>(), "File to write gams output. If not set gams is written to stdout." )
-   ( "lookup-type,l", po::value<std::string>()->default_value( "interactive" ), "Formulation type of lookups. sos2, spline or interactive" )
-   ( "lookup-infinity,f", po::value<double>()->default_value( 1e5 ), "Value for lookup boundaries. Too small values may yield an infeasible gams-model. Too big values may result in numerical instabilities." )
+   ( "batch", po::value<std::string>(), "Manifest file with one conversion per line, given by its input files and options including an output file. The conversions are run on a pool of threads and models used by several conversions are parsed once. The exit status is 1 if an entry failed." )
+   ( "jobs,j", po::value<unsigned>()->default_value( 0 ), "Number of threads for batch mode. 0 uses one thread per hardware thread." )
+   ( "serve", po::value<std::string>(), "Serve conversion requests on the given unix socket. Parsed models are kept in memory between requests." )
+   ( "watch", "Convert the model again whenever one of the input files changes. Requires an output file, which is only rewritten where it changed." )
+   ( "profile", po::value<std::string>(), "Write the wall time, cpu time, peak memory and allocations of each phase of the conversion and counters of the work done in them as json to the given file." )
+   ( "cache", po::value<std::string>(), "Directory of a cache of conversion results. Conversions whose input files and options are unchanged are read from the cache instead of parsing the model. Conversions with interactive lookup-type are not cached. The control and objective files are part of the key, so conversions of one model with different control or objective files do not share entries; use --serve to keep one parsed model for them." )
    ;
+   gams::add_conversion_options( desc );
    po::positional_options_description p;
    p.add( "input-files", -1 );
 
@@ -49,13 +55,61 @@ int main( int argc, char const* argv[] )
       exit( 0 );
    }
 
+   std::unique_ptr<gams::ConversionCache> cache;
+
+   if( vm.count( "cache" ) )
+   {
+      try
+      {
+         cache = std::unique_ptr<gams::ConversionCache>{ new gams::ConversionCache( vm["cache"].as<std::string>() ) };
+      }
+      catch( const std::runtime_error &err )
+      {
+         std::cerr << "Error: " << err.what() << "\n";
+         exit( 0 );
+      }
+   }
+
+   if( vm.count( "batch" ) )
+   {
+      int failed;
+
+      try
+      {
+         failed = gams::run_batch( vm["batch"].as<std::string>(), desc, vm["jobs"].as<unsigned>(), cache.get(), std::cerr );
+      }
+      catch( const std::runtime_error &err )
+      {
+         std::cerr << "Error: " << err.what() << "\n";
+         failed = 1;
+      }
+
+      //scripts detect failed entries by the exit status
+      exit( failed > 0 ? 1 : 0 );
+   }
+
+   if( vm.count( "serve" ) )
+   {
+      try
+      {
+         gams::run_server( vm["serve"].as<std::string>(), desc, cache.get(), std::cerr );
+      }
+      catch( const std::runtime_error &err )
+      {
+         std::cerr << "Error: " << err.what() << "\n";
+      }
+
+      exit( 0 );
+   }
+
    if( !vm.count( "input-files" ) )
    {
       std::cerr << "Error: no input file specified\n" << desc;
       exit( 0 );
    }
    std::unique_ptr<std::ofstream> file;
-   if(vm.count( "output-file" ))
+   //in watch mode the output file is patched instead of truncated
+   if(vm.count( "output-file" ) && !vm.count( "watch" ))
       file = std::unique_ptr<std::ofstream>{ new std::ofstream(vm["output-file"].as<std::string >()) };
 
    std::ostream &out = file ? *file : std::cout;
@@ -65,94 +119,49 @@ int main( int argc, char const* argv[] )
       exit( 0 );
    }
 
-   std::unordered_map<sdo::LookupTable*, gams::LookupData> lkpTypes;
+   gams::ConversionOptions options;
+   gams::ConversionInputs inputs;
 
-   std::vector<std::string> input_files = vm["input-files"].as< std::vector<std::string> >();
-   std::string discretization_method_name = vm["discretization-method"].as<std::string >();
-   std::string lookup_type = vm["lookup-type"].as<std::string>();
-   if(lookup_type != "sos2" && lookup_type != "spline" && lookup_type != "interactive")
+   try
+   {
+      options = gams::get_conversion_options( vm );
+      inputs = gams::get_conversion_inputs( vm["input-files"].as< std::vector<std::string> >() );
+   }
+   catch( const sdo::parse_error &err )
    {
-      std::cerr << "Error: unknown lookup-type '" << lookup_type << "'\n";
+      std::cerr << err.what();
       exit( 0 );
    }
-
-   sdo::ButcherTableau::Name discretization_method;
-
-   if( discretization_method_name == "euler" )
-      discretization_method = sdo::ButcherTableau::EULER;
-   else if( discretization_method_name == "rk2" )
-      discretization_method = sdo::ButcherTableau::RUNGE_KUTTA_2;
-   else if( discretization_method_name == "rk3" )
-      discretization_method = sdo::ButcherTableau::RUNGE_KUTTA_3;
-   else if( discretization_method_name == "rk4" )
-      discretization_method = sdo::ButcherTableau::RUNGE_KUTTA_4;
-   else if( discretization_method_name == "imid2" )
-      discretization_method = sdo::ButcherTableau::IMPLICIT_MIDPOINT_2;
-   else if( discretization_method_name == "igl4" )
-      discretization_method = sdo::ButcherTableau::GAUSS_LEGENDRE_4;
-   else
+   catch( const std::runtime_error &err )
    {
-      std::cerr << "error: unknow discretization method '" << discretization_method_name << "'\n";
+      std::cerr << "Error: " << err.what() << "\n";
       exit( 0 );
    }
 
-   std::vector<std::string> mdlFiles;
-   std::vector<std::string> vocFiles;
-   std::vector<std::string> vpdFiles;
-
-   for( std::vector<std::string>::iterator iter = input_files.begin(); iter != input_files.end(); ++iter )
+   options.chooseLookupType = []( const std::string& name, const std::vector<std::string>& usages )
    {
-      if( boost::algorithm::ends_with( *iter, ".mdl" ) )
-         mdlFiles.push_back( *iter );
-      else if( boost::algorithm::ends_with( *iter, ".voc" ) )
-         vocFiles.push_back( *iter );
-      else if( boost::algorithm::ends_with( *iter, ".vop" ) || boost::algorithm::ends_with( *iter, ".sdo" ) )
-      {
-         try
-         {
-
-            sdo::VopFile vopfile = sdo::parse_vop_file(*iter);
-
-            if( !vopfile.getModelFile().empty() )
-               mdlFiles.push_back( vopfile.getModelFile() );
+      int type = -1;
+      std::cout << "Found Lookup '" << name << "' used at: \n";
 
-            if( !vopfile.getControlFile().empty() )
-               vocFiles.push_back( vopfile.getControlFile() );
+      for( auto& usage : usages )
+         std::cout << "\t" << usage << "\n";
 
-            if( !vopfile.getObjectiveFile().empty() )
-               vpdFiles.push_back( vopfile.getObjectiveFile() );
-         }
-         catch( const sdo::parse_error &err )
-         {
-            std::cerr << err.what();
-         }
-         catch( const std::ifstream::failure &err ) {
-            std::cerr << "Error: cannot read file '" << *iter << "': " << err.what();
-         }
-      }
-      else if( boost::algorithm::ends_with( *iter, ".vpd" ) )
-      {
-         vpdFiles.push_back( *iter );
-      }
-      else
+      do
       {
-         std::cerr << "Error: unknown file type '" << *iter << "'\n";
-         exit( 0 );
+         std::cout << "Choose type [0=SPLINE, 1=SOS2]: ";
+         std::cin >> type;
       }
-   }
+      while( type != 0 && type != 1 );
 
-   std::string objectiveFile;
+      return type == 0 ? gams::LookupFormulationType::SPLINE : gams::LookupFormulationType::SOS2;
+   };
 
-   if(vpdFiles.size() == 1)
-   {
-      objectiveFile = vpdFiles.front();
-   }
-   else if( vpdFiles.size() > 1 )
+   if( inputs.vpdFiles.size() > 1 )
    {
       std::cerr << "Found multiple objective functions:\n";
 
-      for( std::size_t i = 0; i < vpdFiles.size(); ++i )
-         std::cerr << "[ " << i << " ]: " << vpdFiles[i] << "\n";
+      for( std::size_t i = 0; i < inputs.vpdFiles.size(); ++i )
+         std::cerr << "[ " << i << " ]: " << inputs.vpdFiles[i] << "\n";
 
       while( true )
       {
@@ -160,90 +169,66 @@ int main( int argc, char const* argv[] )
          unsigned choice;
          std::cin >> choice;
 
-         if( std::cin.good() && choice < vpdFiles.size() )
+         if( std::cin.good() && choice < inputs.vpdFiles.size() )
          {
-            objectiveFile = vpdFiles[choice];
+            inputs.vpdFiles = { inputs.vpdFiles[choice] };
             break;
          }
       }
    }
 
-   try
+   if( vm.count( "watch" ) )
    {
-      sdo::ExpressionGraph exprGraph;
-      exprGraph.useUniqueConstants(true);
+      if( !vm.count( "output-file" ) || options.lookupType == "interactive" )
+      {
+         std::cerr << "Error: watch mode requires an output file and a lookup-type\n";
+         exit( 0 );
+      }
 
-      for(auto &vocFile : vocFiles)
+      try
       {
-         try
-         {
-            sdo::parse_voc_file(vocFile, exprGraph);
-         }
-         catch( const std::ifstream::failure &err )
-         {
-            std::cerr << "Error: cannot read file '" << vocFile << "'\n";
-         }
+         gams::run_watch( inputs, options, vm["output-file"].as<std::string>(), std::cerr );
       }
-      for(auto &mdlFile: mdlFiles)
+      catch( const std::runtime_error &err )
       {
-         try
-         {
-            sdo::parse_mdl_file(mdlFile, exprGraph);
-         }
-         catch( const std::ifstream::failure &err )
-         {
-            std::cerr << "Error: cannot read file '" << mdlFile << "'\n";
-         }
+         std::cerr << "Error: " << err.what() << "\n";
       }
 
-      exprGraph.analyze();
-
-      gams::GamsGenerator gams(exprGraph, discretization_method);
-
-      if(lookup_type == "sos2")
-         gams.setLookupFormulationTypes(gams::LookupFormulationType::SOS2);
-      else if(lookup_type == "interactive") {
-         for(auto& entry : exprGraph.getSymbolTable()) {
-            sdo::LookupTable* lkpTable;
-            if(entry.second->op == sdo::ExpressionGraph::LOOKUP_TABLE) {
-               lkpTable = entry.second->lookup_table;
-            } else if (entry.second->op == sdo::ExpressionGraph::APPLY_LOOKUP) {
-               auto range = exprGraph.getSymbol(entry.second->child1);
-               if(!range.empty())
-                  continue;
-               lkpTable = entry.second->child1->lookup_table;
-            } else {
-               continue;
-            }
-
-            int type = -1;
-            std::cout << "Found Lookup '" << entry.first << "' used at: \n";
-            for( auto &usage : entry.second->usages )
-               std::cout <<  "\t" << usage << "\n";
-            do {
-               std::cout << "Choose type [0=SPLINE, 1=SOS2]: ";
-               std::cin >> type;
-            } while(type != 0 && type != 1);
-
-            if(type == 0) {
-               gams.setLookupFormulationType(lkpTable, gams::LookupData{ entry.first, gams::LookupFormulationType::SPLINE});
-            } else {
-               gams.setLookupFormulationType(lkpTable, gams::LookupData{ entry.first, gams::LookupFormulationType::SOS2});
-            }
-         }
-      }
+      exit( 0 );
+   }
 
-      if( !objectiveFile.empty() )
+   try
+   {
+      sdo::ExpressionGraph exprGraph;
+      std::string outputFile = vm.count( "output-file" ) ? vm["output-file"].as<std::string>() : std::string();
+      std::unique_ptr<gams::Profile> profile;
+
+      if( vm.count( "profile" ) )
+         profile = std::unique_ptr<gams::Profile>{ new gams::Profile };
+
+      if( cache )
       {
-         sdo::Objective objective;
-         sdo::parse_vpd_file(objectiveFile, objective);
-         gams.addObjective(std::move(objective));
+         gams::convert_cached( *cache, [&]() -> sdo::ExpressionGraph&
+         {
+            gams::parse_model( inputs, exprGraph, profile.get() );
+            return exprGraph;
+         }, inputs, options, out, outputFile, profile.get() );
+         cache->printStatistics( std::cerr );
       }
       else
       {
-         gams.addArbitraryObjective();
+         gams::parse_model( inputs, exprGraph, profile.get() );
+         gams::convert( exprGraph, inputs, options, out, outputFile, profile.get() );
+      }
+
+      if( profile )
+      {
+         std::ofstream profileFile( vm["profile"].as<std::string>() );
+         profile->writeJson( profileFile );
+
+         if( !profileFile.good() )
+            std::cerr << "Error: unable to write to file '" << vm["profile"].as<std::string>() << "'\n";
       }
-      gams.emitGams( out );
    }
    catch( const sdo::parse_error &err )
    {
@@ -253,6 +238,10 @@ int main( int argc, char const* argv[] )
    {
       std::cerr << "Error: cannot read file\n";
    }
+   catch( const std::runtime_error &err )
+   {
+      std::cerr << "Error: " << err.what() << "\n";
+   }
 
    return 0;
 }
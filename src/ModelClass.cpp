@@ -0,0 +1,353 @@
+#include <algorithm>
+#include "GamsGenerator.hpp"
+
+namespace gams
+{
+
+/**
+ * Nonlinearity of the product of two expressions with the given nonlinearities.
+ */
+static Nonlinearity product( Nonlinearity a, Nonlinearity b, bool same )
+{
+   if( a == Nonlinearity::CONSTANT )
+      return b;
+
+   if( b == Nonlinearity::CONSTANT )
+      return a;
+
+   if( a == Nonlinearity::LINEAR && b == Nonlinearity::LINEAR )
+      return same ? Nonlinearity::QUADRATIC : Nonlinearity::BILINEAR;
+
+   return std::max( Nonlinearity::NONLINEAR, std::max( a, b ) );
+}
+
+Nonlinearity GamsGenerator::classify( FlatGraph::Index index, bool initial, bool root )
+{
+   countVisit();
+   ExpressionGraph::Node* node = flat_.getNode( index );
+   ExpressionGraph::Op op = flat_.getOp( index );
+
+   if( !root && flat_.hasSymbol( index ) )
+   {
+      //symbols are leaves that are translated in the same way as in translate()
+      if( !initial )
+         return flat_.getType( index ) == ExpressionGraph::DYNAMIC_NODE ? Nonlinearity::LINEAR : Nonlinearity::CONSTANT;
+
+      if( op == ExpressionGraph::INTEG )
+         return node->init == ExpressionGraph::CONSTANT_INIT ? Nonlinearity::CONSTANT : Nonlinearity::LINEAR;
+
+      if( op == ExpressionGraph::CONTROL )
+         return Nonlinearity::LINEAR;
+
+      if( !isScenarioNode( node ) || flat_.getType( index ) == ExpressionGraph::CONSTANT_NODE )
+         return Nonlinearity::CONSTANT;
+   }
+
+   //removed identity operations are not counted
+   if( ExpressionGraph::Node* operand = getSimplifiedOperand( node, initial ) )
+      return classify( flat_.getIndex( operand ), initial, false );
+
+   Nonlinearity own;
+   Nonlinearity result;
+
+   switch( op )
+   {
+   case ExpressionGraph::TIME:
+   case ExpressionGraph::CONSTANT:
+   case ExpressionGraph::RANDOM_UNIFORM:
+   case ExpressionGraph::LOOKUP_TABLE:
+   case ExpressionGraph::NIL:
+      return Nonlinearity::CONSTANT;
+
+   case ExpressionGraph::CONTROL:
+      return Nonlinearity::LINEAR;
+
+   case ExpressionGraph::INTEG:
+      return classify( initial ? flat_.getChild2( index ) : flat_.getChild1( index ), initial, false );
+
+   case ExpressionGraph::INITIAL:
+      return classify( flat_.getChild1( index ), true, false );
+
+   case ExpressionGraph::ACTIVE_INITIAL:
+      return classify( initial ? flat_.getChild2( index ) : flat_.getChild1( index ), initial, false );
+
+   case ExpressionGraph::DELAY_FIXED:
+      if( initial )
+         return classify( flat_.getChild3( index ), true, false );
+
+      result = std::max( classify( flat_.getChild1( index ), false, false ), classify( flat_.getChild3( index ), true, false ) );
+      own = Nonlinearity::LINEAR;
+      break;
+
+   case ExpressionGraph::APPLY_LOOKUP:
+      //the initial value of a lookup is evaluated during translation
+      if( initial )
+         return Nonlinearity::CONSTANT;
+
+      result = classify( flat_.getChild2( index ), false, false );
+
+      if( result == Nonlinearity::CONSTANT )
+         return result;
+
+      //the argument of a sos2 lookup is part of a separate equation
+      if( lkpData_[node->child1->lookup_table].type == LookupFormulationType::SOS2 )
+      {
+         ++operatorCounts_[int( Nonlinearity::LINEAR )];
+         return Nonlinearity::LINEAR;
+      }
+
+      own = Nonlinearity::NONLINEAR;
+      break;
+
+   case ExpressionGraph::PLUS:
+   case ExpressionGraph::MINUS:
+      result = std::max( classify( flat_.getChild1( index ), initial, false ), classify( flat_.getChild2( index ), initial, false ) );
+      own = Nonlinearity::LINEAR;
+      break;
+
+   case ExpressionGraph::UMINUS:
+      result = classify( flat_.getChild1( index ), initial, false );
+      own = Nonlinearity::LINEAR;
+      break;
+
+   case ExpressionGraph::MULT:
+   {
+      Nonlinearity a = classify( flat_.getChild1( index ), initial, false );
+      Nonlinearity b = classify( flat_.getChild2( index ), initial, false );
+      result = product( a, b, flat_.getChild1( index ) == flat_.getChild2( index ) );
+
+      if( a == Nonlinearity::CONSTANT || b == Nonlinearity::CONSTANT )
+         own = Nonlinearity::LINEAR;
+      else if( a == Nonlinearity::LINEAR && b == Nonlinearity::LINEAR )
+         own = result;
+      else
+         own = Nonlinearity::NONLINEAR;
+
+      break;
+   }
+
+   case ExpressionGraph::DIV:
+   {
+      Nonlinearity divisor = classify( flat_.getChild2( index ), initial, false );
+      result = std::max( classify( flat_.getChild1( index ), initial, false ), divisor );
+      own = divisor == Nonlinearity::CONSTANT ? Nonlinearity::LINEAR : Nonlinearity::NONLINEAR;
+
+      //the quotient variable is multiplied with the divisor in its defining equation
+      if( !initial && quotientIds_.find( node ) != quotientIds_.end() )
+         own = product( Nonlinearity::LINEAR, divisor, false );
+
+      break;
+   }
+
+   case ExpressionGraph::POWER:
+   {
+      Nonlinearity base = classify( flat_.getChild1( index ), initial, false );
+      Nonlinearity exponent = classify( flat_.getChild2( index ), initial, false );
+      result = std::max( base, exponent );
+
+      if( exponent == Nonlinearity::CONSTANT && flat_.getValue( flat_.getChild2( index ) ) == 1. )
+         own = Nonlinearity::LINEAR;
+      else if( exponent == Nonlinearity::CONSTANT && flat_.getValue( flat_.getChild2( index ) ) == 2. && base == Nonlinearity::LINEAR )
+         own = Nonlinearity::QUADRATIC;
+      else if( exponent == Nonlinearity::CONSTANT && flat_.getValue( flat_.getChild2( index ) ) == 0. )
+         return Nonlinearity::CONSTANT;
+      else
+         own = Nonlinearity::NONLINEAR;
+
+      break;
+   }
+
+   case ExpressionGraph::SQRT:
+   case ExpressionGraph::EXP:
+   case ExpressionGraph::LN:
+   case ExpressionGraph::SIN:
+   case ExpressionGraph::COS:
+   case ExpressionGraph::TAN:
+   case ExpressionGraph::ARCSIN:
+   case ExpressionGraph::ARCCOS:
+   case ExpressionGraph::ARCTAN:
+   case ExpressionGraph::SINH:
+   case ExpressionGraph::COSH:
+   case ExpressionGraph::TANH:
+      result = classify( flat_.getChild1( index ), initial, false );
+      own = Nonlinearity::NONLINEAR;
+      break;
+
+   case ExpressionGraph::LOG:
+      result = std::max( classify( flat_.getChild1( index ), initial, false ), classify( flat_.getChild2( index ), initial, false ) );
+      own = Nonlinearity::NONLINEAR;
+      break;
+
+   case ExpressionGraph::ABS:
+   case ExpressionGraph::INTEGER:
+   case ExpressionGraph::NOT:
+      result = classify( flat_.getChild1( index ), initial, false );
+      own = Nonlinearity::DISCONTINUOUS;
+      break;
+
+   case ExpressionGraph::MIN:
+   case ExpressionGraph::MAX:
+   case ExpressionGraph::MODULO:
+   case ExpressionGraph::G:
+   case ExpressionGraph::GE:
+   case ExpressionGraph::L:
+   case ExpressionGraph::LE:
+   case ExpressionGraph::EQ:
+   case ExpressionGraph::NEQ:
+   case ExpressionGraph::AND:
+   case ExpressionGraph::OR:
+      result = std::max( classify( flat_.getChild1( index ), initial, false ), classify( flat_.getChild2( index ), initial, false ) );
+      own = Nonlinearity::DISCONTINUOUS;
+      break;
+
+   case ExpressionGraph::IF:
+   {
+      //the condition is multiplied with the branches
+      Nonlinearity condition = classify( flat_.getChild1( index ), initial, false );
+      result = std::max( classify( flat_.getChild2( index ), initial, false ), classify( flat_.getChild3( index ), initial, false ) );
+
+      if( condition == Nonlinearity::CONSTANT )
+         return result;
+
+      own = product( condition, result, false );
+      result = std::max( condition, result );
+      break;
+   }
+
+   case ExpressionGraph::STEP:
+   {
+      //the indicator of the step time is multiplied with the height
+      Nonlinearity time = classify( flat_.getChild2( index ), initial, false );
+      result = classify( flat_.getChild1( index ), initial, false );
+
+      if( time == Nonlinearity::CONSTANT )
+         return result;
+
+      own = Nonlinearity::DISCONTINUOUS;
+      break;
+   }
+
+   case ExpressionGraph::RAMP:
+   {
+      //the slope is multiplied with a function of time and the start and end time
+      Nonlinearity time = std::max( classify( flat_.getChild2( index ), initial, false ), classify( flat_.getChild3( index ), initial, false ) );
+      result = classify( flat_.getChild1( index ), initial, false );
+
+      if( time == Nonlinearity::CONSTANT )
+         return result;
+
+      own = Nonlinearity::DISCONTINUOUS;
+      break;
+   }
+
+   case ExpressionGraph::PULSE:
+      result = std::max( classify( flat_.getChild1( index ), initial, false ), classify( flat_.getChild2( index ), initial, false ) );
+      own = Nonlinearity::DISCONTINUOUS;
+      break;
+
+   case ExpressionGraph::PULSE_TRAIN:
+      result = std::max( classify( flat_.getChild1( index ), initial, false ), classify( flat_.getChild2( index ), initial, false ) );
+      result = std::max( result, classify( flat_.getChild3( index ), initial, false ) );
+      own = Nonlinearity::DISCONTINUOUS;
+      break;
+
+   default:
+      return Nonlinearity::NONLINEAR;
+   }
+
+   //operators are only counted if they are applied to variables
+   if( result == Nonlinearity::CONSTANT )
+      return result;
+
+   //reformulated operators are smooth or linear in their auxiliary variables
+   if( own == Nonlinearity::DISCONTINUOUS && !initial )
+   {
+      Reformulation reformulation = getReformulation( op );
+
+      if( bigmIds_.find( node ) != bigmIds_.end() )
+         own = Nonlinearity::LINEAR;
+      else if( reformulation == Reformulation::SMOOTH )
+         own = Nonlinearity::NONLINEAR;
+      else if( reformulation == Reformulation::BIGM && op == ExpressionGraph::NOT )
+         own = Nonlinearity::LINEAR;
+      else if( reformulation == Reformulation::BIGM && ( op == ExpressionGraph::AND || op == ExpressionGraph::OR ) )
+         own = Nonlinearity::BILINEAR;
+   }
+
+   ++operatorCounts_[int( own )];
+   return std::max( result, own );
+}
+
+void GamsGenerator::analyzeModelClass()
+{
+   std::fill( operatorCounts_.begin(), operatorCounts_.end(), 0 );
+   modelClass_ = Nonlinearity::LINEAR;
+
+   for( auto & entry : getSymbolTable() )
+   {
+      ExpressionGraph::Node* node = entry.second;
+
+      if( node->type != ExpressionGraph::DYNAMIC_NODE || node->op == ExpressionGraph::CONTROL || !isLive( node ) )
+         continue;
+
+      //the definition of a folded family is emitted once
+      auto folded = foldedMembers_.find( node );
+
+      if( folded != foldedMembers_.end() && folded->second.second != 0 )
+         continue;
+
+      FlatGraph::Index index = flat_.getIndex( node );
+      Nonlinearity nonlinearity;
+
+      if( node->op == ExpressionGraph::INTEG )
+      {
+         nonlinearity = classify( flat_.getChild1( index ), false, false );
+
+         //a constant initial value fixes the variable, otherwise an equation is emitted
+         if( node->init != ExpressionGraph::CONSTANT_INIT )
+            nonlinearity = std::max( nonlinearity, classify( flat_.getChild2( index ), true, false ) );
+      }
+      else
+      {
+         nonlinearity = classify( index, false, true );
+      }
+
+      modelClass_ = std::max( modelClass_, nonlinearity );
+   }
+
+   //the equations defining the arguments of the sos2 lookups
+   for( auto & entry : sos2LkpIds_ )
+   {
+      if( isLive( entry.first ) )
+         modelClass_ = std::max( modelClass_, classify( flat_.getChild2( flat_.getIndex( entry.first ) ), false, false ) );
+   }
+}
+
+std::string GamsGenerator::getModelType() const
+{
+   bool discrete = !bigmIds_.empty() || std::any_of( sos2LkpIds_.begin(), sos2LkpIds_.end(), [this]( const std::pair<ExpressionGraph::Node* const, int>& entry )
+   {
+      return isLive( entry.first );
+   } );
+
+   switch( modelClass_ )
+   {
+   case Nonlinearity::CONSTANT:
+   case Nonlinearity::LINEAR:
+      return discrete ? "mip" : "lp";
+
+   case Nonlinearity::BILINEAR:
+   case Nonlinearity::QUADRATIC:
+      return discrete ? "miqcp" : "qcp";
+
+   case Nonlinearity::NONLINEAR:
+      return discrete ? "minlp" : "nlp";
+
+   case Nonlinearity::DISCONTINUOUS:
+      return discrete ? "minlp" : "dnlp";
+   }
+
+   return "minlp";
+}
+
+}
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cctype>
+#include "NameTable.hpp"
+#include "Escape.hpp"
+
+namespace gams
+{
+
+constexpr NameTable::Id NameTable::RESERVED;
+
+std::string NameTable::to_lower( const std::string& name )
+{
+   std::string lowered( name );
+
+   //the escaped names are ascii, so the letters are lowered without a locale
+   for( char& c : lowered )
+   {
+      if( c >= 'A' && c <= 'Z' )
+         c += 'a' - 'A';
+   }
+
+   return lowered;
+}
+
+bool NameTable::matches( const std::string& lowered, Pattern kind ) const
+{
+   for( auto& pattern : patterns_ )
+   {
+      const std::string& part = pattern.first;
+
+      switch( pattern.second )
+      {
+      case Pattern::PREFIX:
+      case Pattern::NUMBERED:
+         if( kind != Pattern::PREFIX || lowered.compare( 0, part.size(), part ) != 0 )
+            continue;
+
+         if( pattern.second == Pattern::PREFIX
+               || ( lowered.size() > part.size() && std::isdigit( static_cast<unsigned char>( lowered[part.size()] ) ) ) )
+            return true;
+
+         continue;
+
+      case Pattern::REPEATED:
+         if( kind != Pattern::REPEATED || lowered.size() < 2 * part.size() || lowered.size() % part.size() != 0 )
+            continue;
+
+         for( std::size_t i = 0; i < lowered.size(); i += part.size() )
+         {
+            if( lowered.compare( i, part.size(), part ) != 0 )
+               break;
+
+            if( i + part.size() == lowered.size() )
+               return true;
+         }
+
+         continue;
+      }
+   }
+
+   return false;
+}
+
+void NameTable::reserve( const std::string& name )
+{
+   owners_.emplace( to_lower( name ), RESERVED );
+}
+
+void NameTable::reserve( const std::string& part, Pattern pattern )
+{
+   patterns_.emplace_back( to_lower( part ), pattern );
+}
+
+void NameTable::addSymbols( const sdo::ExpressionGraph::SymbolTable& symbols )
+{
+   for( auto& entry : symbols )
+      add( entry.first );
+}
+
+NameTable::Id NameTable::add( const sdo::Symbol& symbol )
+{
+   auto found = ids_.find( &symbol.get() );
+
+   if( found != ids_.end() )
+      return found->second;
+
+   Id id = names_.size();
+   std::string escaped = escape_string( symbol.get() );
+   std::string lowered = to_lower( escaped );
+   std::string name = escaped;
+
+   if( isTaken( lowered ) )
+   {
+      auto owner = owners_.find( lowered );
+      bool prefixed = matches( lowered, Pattern::PREFIX );
+      sdo::Symbol other = owner != owners_.end() && owner->second != RESERVED ? symbols_[owner->second] : sdo::Symbol();
+      collisions_.push_back( Collision { symbol, other, escaped } );
+
+      //suffixes do not remove a reserved prefix, so the name is prefixed instead
+      std::string base = prefixed ? ( "x" + escaped ).substr( 0, 59 ) : escaped;
+      name = base;
+
+      for( int n = 2; isTaken( to_lower( name ) ); ++n )
+      {
+         //the suffix replaces the end if the name has the maximal length
+         std::string suffix = "_" + std::to_string( n );
+         name = base.substr( 0, std::min<std::size_t>( base.size(), 59 - suffix.size() ) ) + suffix;
+      }
+   }
+
+   ids_.emplace( &symbol.get(), id );
+   owners_.emplace( to_lower( name ), id );
+   symbols_.push_back( symbol );
+   names_.push_back( std::move( name ) );
+   return id;
+}
+
+}
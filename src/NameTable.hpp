@@ -0,0 +1,129 @@
+#ifndef _GAMS_NAME_TABLE_HPP_
+#define _GAMS_NAME_TABLE_HPP_
+
+#include <sdo/ExpressionGraph.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace gams {
+
+/**
+ * \brief The gams identifiers of the symbols of a model.
+ *
+ * Each symbol is escaped once when it is added. Escaping can map several symbols to the same
+ * identifier, e.g. if they only differ in spaces or are shortened to the same 59 characters.
+ * The first symbol added keeps the identifier and the others get the smallest suffix _2, _3, ...
+ * that makes theirs unique. The identifier of a symbol never changes once it is added, so
+ * symbols can be added while the identifiers of the others are already in use.
+ *
+ * Gams does not distinguish the case of identifiers, so identifiers that only differ in case
+ * collide as well. The identifiers of the generated model are reserved before the symbols are
+ * added. Symbols whose escaped name starts with a reserved prefix are prefixed with an x, as
+ * no suffix makes them unique.
+ */
+class NameTable {
+public:
+   typedef std::uint32_t Id;
+
+   /**
+    * \brief A symbol whose identifier was changed because its escaped name was already taken.
+    */
+   struct Collision {
+      sdo::Symbol symbol;
+      sdo::Symbol other; //< the symbol that has the escaped name as identifier or empty if it is reserved
+      std::string escaped;
+   };
+
+   /**
+    * \brief Reserve an identifier of the generated model, so that no symbol gets it.
+    */
+   void reserve( const std::string& name );
+
+   /**
+    * \brief The identifiers reserved by a pattern.
+    */
+   enum class Pattern {
+      PREFIX, //< the identifiers that start with the part
+      NUMBERED, //< the identifiers that start with the part followed by a digit
+      REPEATED //< the identifiers that repeat the part at least twice, e.g. the aliases of a set
+   };
+
+   /**
+    * \brief Reserve the identifiers of the generated model that match a pattern.
+    */
+   void reserve( const std::string& part, Pattern pattern );
+
+   /**
+    * \brief Check whether an identifier is neither reserved nor the identifier of a symbol.
+    */
+   bool isAvailable( const std::string& name ) const {
+      return !isTaken( to_lower( name ) );
+   }
+
+   /**
+    * \brief Add the symbols of the table that are not added yet in the order of the table.
+    */
+   void addSymbols( const sdo::ExpressionGraph::SymbolTable& symbols );
+
+   /**
+    * \brief Add a symbol if it is not added yet and get its id.
+    */
+   Id add( const sdo::Symbol& symbol );
+
+   /**
+    * \brief Get the id of a symbol that was added.
+    *
+    * \throws std::out_of_range if the symbol was not added
+    */
+   Id getId( const sdo::Symbol& symbol ) const {
+      return ids_.at( &symbol.get() );
+   }
+
+   const std::string& getName( Id id ) const {
+      return names_[id];
+   }
+
+   /**
+    * \brief Get the identifier of a symbol that was added.
+    *
+    * \throws std::out_of_range if the symbol was not added
+    */
+   const std::string& getName( const sdo::Symbol& symbol ) const {
+      return names_[getId( symbol )];
+   }
+
+   const std::vector<Collision>& getCollisions() const {
+      return collisions_;
+   }
+
+private:
+   static constexpr Id RESERVED = UINT32_MAX;
+
+   static std::string to_lower( const std::string& name );
+
+   bool isTaken( const std::string& lowered ) const {
+      return owners_.count( lowered ) || matches( lowered, Pattern::PREFIX ) || matches( lowered, Pattern::REPEATED );
+   }
+
+   /**
+    * Check whether a lowered identifier matches a reserved pattern. The numbered patterns
+    * are checked together with the prefixes, as suffixes do not remove either.
+    */
+   bool matches( const std::string& lowered, Pattern kind ) const;
+
+   //the symbols are interned, so the address of their string identifies them
+   std::unordered_map<const std::string*, Id> ids_;
+   std::unordered_map<std::string, Id> owners_; //< the id of the symbol having each identifier in lower case or RESERVED
+   std::vector<std::pair<std::string, Pattern>> patterns_; //< the reserved patterns with their parts in lower case
+   std::vector<sdo::Symbol> symbols_; //< indexed by id, keeps the strings of the symbols alive
+   std::vector<std::string> names_; //< indexed by id
+   std::vector<Collision> collisions_;
+};
+
+}
+
+#endif
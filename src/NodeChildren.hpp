@@ -0,0 +1,105 @@
+#ifndef _GAMS_NODE_CHILDREN_HPP_
+#define _GAMS_NODE_CHILDREN_HPP_
+
+#include <sdo/ExpressionGraph.hpp>
+
+namespace gams {
+
+using sdo::ExpressionGraph;
+
+/**
+ * Stores the children of a node with the given operator and child references, that its value
+ * depends on, in the given array. The references are nodes or the indices of a FlatGraph.
+ * The bounds of a control are not considered as children.
+ * 
+ * \param op the operator of the node
+ * \param child1 the first child of the node
+ * \param child2 the second child of the node
+ * \param child3 the third child of the node
+ * \param children array receiving the children
+ * \return the number of children
+ */
+template<typename Child>
+inline int get_children( ExpressionGraph::Op op, Child child1, Child child2, Child child3, Child children[3] )
+{
+   int n = 0;
+
+   switch( op )
+   {
+   case ExpressionGraph::IF:
+   case ExpressionGraph::DELAY_FIXED:
+   case ExpressionGraph::PULSE_TRAIN:
+   case ExpressionGraph::RAMP:
+      children[n++] = child3;
+
+   case ExpressionGraph::APPLY_LOOKUP:
+   case ExpressionGraph::PULSE:
+   case ExpressionGraph::ACTIVE_INITIAL:
+   case ExpressionGraph::STEP:
+   case ExpressionGraph::RANDOM_UNIFORM:
+   case ExpressionGraph::PLUS:
+   case ExpressionGraph::MINUS:
+   case ExpressionGraph::MULT:
+   case ExpressionGraph::DIV:
+   case ExpressionGraph::G:
+   case ExpressionGraph::GE:
+   case ExpressionGraph::L:
+   case ExpressionGraph::LE:
+   case ExpressionGraph::EQ:
+   case ExpressionGraph::NEQ:
+   case ExpressionGraph::AND:
+   case ExpressionGraph::OR:
+   case ExpressionGraph::POWER:
+   case ExpressionGraph::LOG:
+   case ExpressionGraph::MIN:
+   case ExpressionGraph::MAX:
+   case ExpressionGraph::MODULO:
+   case ExpressionGraph::INTEG:
+      children[n++] = child2;
+
+   case ExpressionGraph::INITIAL:
+   case ExpressionGraph::UMINUS:
+   case ExpressionGraph::SQRT:
+   case ExpressionGraph::EXP:
+   case ExpressionGraph::LN:
+   case ExpressionGraph::ABS:
+   case ExpressionGraph::INTEGER:
+   case ExpressionGraph::NOT:
+   case ExpressionGraph::SIN:
+   case ExpressionGraph::COS:
+   case ExpressionGraph::TAN:
+   case ExpressionGraph::ARCSIN:
+   case ExpressionGraph::ARCCOS:
+   case ExpressionGraph::ARCTAN:
+   case ExpressionGraph::SINH:
+   case ExpressionGraph::COSH:
+   case ExpressionGraph::TANH:
+      children[n++] = child1;
+
+   case ExpressionGraph::TIME:
+   case ExpressionGraph::CONSTANT:
+   case ExpressionGraph::CONTROL:
+   case ExpressionGraph::LOOKUP_TABLE:
+   case ExpressionGraph::NIL:
+      break;
+   };
+
+   return n;
+}
+
+/**
+ * Stores the children of a node, that its value depends on, in the given array.
+ * The bounds of a control are not considered as children.
+ * 
+ * \param node the node
+ * \param children array receiving the children
+ * \return the number of children
+ */
+inline int get_children( ExpressionGraph::Node* node, ExpressionGraph::Node* children[3] )
+{
+   return get_children( node->op, node->child1, node->child2, node->child3, children );
+}
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "NumberFormat.hpp"
+
+namespace gams
+{
+
+/**
+ * Write an integer with at most 15 digits, which every double represents exactly.
+ */
+static std::size_t format_integer( long long value, char* buffer )
+{
+   char digits[16];
+   std::size_t n = 0;
+   std::size_t length = 0;
+   unsigned long long magnitude = value < 0 ? -static_cast<unsigned long long>( value ) : value;
+
+   do
+   {
+      digits[n++] = '0' + magnitude % 10;
+      magnitude /= 10;
+   }
+   while( magnitude != 0 );
+
+   if( value < 0 )
+      buffer[length++] = '-';
+
+   while( n > 0 )
+      buffer[length++] = digits[--n];
+
+   return length;
+}
+
+std::size_t format_double( double value, int digits, char* buffer )
+{
+   //most constants of models are integers that can be written without printf. Rounded to
+   //fewer digits they are still written exactly if the digits after the rounded ones are zeros.
+   if( std::fabs( value ) < 1e15 && value == std::floor( value ) && !( value == 0. && std::signbit( value ) ) )
+   {
+      std::size_t length = format_integer( static_cast<long long>( value ), buffer );
+      std::size_t significant = length;
+
+      while( significant > 1 && buffer[significant - 1] == '0' )
+         --significant;
+
+      if( buffer[0] == '-' )
+         --significant;
+
+      if( digits == 0 || significant <= static_cast<std::size_t>( digits ) )
+         return length;
+   }
+
+   if( digits > 0 )
+      return std::snprintf( buffer, FORMATTED_DOUBLE_SIZE, "%.*g", digits < 17 ? digits : 17, value );
+
+   //every decimal with at most 15 significant digits reads back as the double closest to it,
+   //so %.15g yields the shortest representation of all doubles that have one with at most
+   //15 digits. The others need 16 or 17 digits. Subnormal doubles have less precision, so the
+   //rounding to 15 digits may not be the shortest representation and fewer digits are tried.
+   for( int precision = std::fabs( value ) < DBL_MIN ? 1 : 15; precision < 17; ++precision )
+   {
+      std::size_t length = std::snprintf( buffer, FORMATTED_DOUBLE_SIZE, "%.*g", precision, value );
+
+      if( std::strtod( buffer, nullptr ) == value )
+         return length;
+   }
+
+   return std::snprintf( buffer, FORMATTED_DOUBLE_SIZE, "%.17g", value );
+}
+
+std::string format_double( double value, int digits )
+{
+   char buffer[FORMATTED_DOUBLE_SIZE];
+   return std::string( buffer, format_double( value, digits, buffer ) );
+}
+
+}
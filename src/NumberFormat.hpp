@@ -0,0 +1,50 @@
+#ifndef _GAMS_NUMBER_FORMAT_HPP_
+#define _GAMS_NUMBER_FORMAT_HPP_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace gams {
+
+/**
+ * \brief Size of a buffer that holds any double written by format_double.
+ */
+constexpr std::size_t FORMATTED_DOUBLE_SIZE = 32;
+
+/**
+ * \brief Write a double without a terminating null character.
+ *
+ * With digits set to 0 the shortest representation that reads back as the same double is
+ * written, otherwise the double is rounded to the given number of significant digits. Integers
+ * that need no rounding are written in full, so that 1000 is not written as 1e+03.
+ *
+ * \param value the double to write
+ * \param digits the number of significant digits or 0
+ * \param buffer the buffer of at least FORMATTED_DOUBLE_SIZE characters the double is written to
+ * \return the number of characters written
+ */
+std::size_t format_double( double value, int digits, char* buffer );
+
+/**
+ * \brief Format a double like format_double as a string.
+ */
+std::string format_double( double value, int digits );
+
+/**
+ * \brief A double that is written to a stream by format_double.
+ */
+struct FormattedDouble {
+   double value;
+   int digits;
+};
+
+inline std::ostream& operator<<( std::ostream& out, FormattedDouble number )
+{
+   char buffer[FORMATTED_DOUBLE_SIZE];
+   return out.write( buffer, format_double( number.value, number.digits, buffer ) );
+}
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cstring>
+#include "OutputBuffer.hpp"
+
+namespace gams
+{
+
+//chunks grow up to this size and are only bigger for fragments that do not fit
+static const std::size_t MAX_CHUNK_SIZE = std::size_t( 1 ) << 22;
+
+bool operator<( const OutputFragment& a, const OutputFragment& b )
+{
+   std::size_t size = std::min( a.size, b.size );
+   int cmp = size == 0 ? 0 : std::memcmp( a.data, b.data, size );
+   return cmp < 0 || ( cmp == 0 && a.size < b.size );
+}
+
+OutputFragment OutputBuffer::take()
+{
+   OutputFragment fragment;
+   fragment.data = fragmentBegin_;
+   fragment.size = pptr() - fragmentBegin_;
+   fragmentBegin_ = pptr();
+   return fragment;
+}
+
+OutputBuffer::int_type OutputBuffer::overflow( int_type c )
+{
+   if( traits_type::eq_int_type( c, traits_type::eof() ) )
+      return traits_type::not_eof( c );
+
+   grow( 1 );
+   *pptr() = traits_type::to_char_type( c );
+   pbump( 1 );
+   return c;
+}
+
+std::streamsize OutputBuffer::xsputn( const char* s, std::streamsize n )
+{
+   if( epptr() - pptr() < n )
+      grow( n );
+
+   std::memcpy( pptr(), s, n );
+   pbump( static_cast<int>( n ) );
+   return n;
+}
+
+void OutputBuffer::grow( std::size_t required )
+{
+   std::size_t size = pptr() - fragmentBegin_;
+   std::size_t chunkSize = std::max( nextChunkSize_, 2 * ( size + required ) );
+   nextChunkSize_ = std::min( 2 * nextChunkSize_, MAX_CHUNK_SIZE );
+
+   chunks_.emplace_back( new char[chunkSize] );
+   char* chunk = chunks_.back().get();
+
+   if( size != 0 )
+      std::memcpy( chunk, fragmentBegin_, size );
+
+   fragmentBegin_ = chunk;
+   setp( chunk, chunk + chunkSize );
+   pbump( static_cast<int>( size ) );
+}
+
+void write_fragments( std::ostream& out, const std::vector<OutputFragment>& fragments )
+{
+   for( const OutputFragment& fragment : fragments )
+      out.write( fragment.data, fragment.size );
+}
+
+}
@@ -0,0 +1,91 @@
+#ifndef _GAMS_OUTPUT_BUFFER_HPP_
+#define _GAMS_OUTPUT_BUFFER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace gams {
+
+/**
+ * \brief Piece of output held by an OutputBuffer.
+ *
+ * The fragment stays valid as long as the buffer it was taken from exists.
+ */
+struct OutputFragment {
+   const char* data = nullptr;
+   std::size_t size = 0;
+
+   std::string str() const {
+      return std::string( data, size );
+   }
+};
+
+/**
+ * \brief Compare fragments byte by byte like strings.
+ */
+bool operator<( const OutputFragment& a, const OutputFragment& b );
+
+/**
+ * \brief Stream buffer that appends the output to large chunks of memory and hands it out as fragments.
+ *
+ * Each fragment is contiguous, so only the unfinished fragment is moved when a chunk is full.
+ * The chunks are never freed or moved before the buffer is destroyed.
+ */
+class OutputBuffer : public std::streambuf {
+public:
+   OutputBuffer() = default;
+   OutputBuffer( const OutputBuffer& ) = delete;
+   OutputBuffer& operator=( const OutputBuffer& ) = delete;
+
+   /**
+    * \brief Get everything written since the last call as a fragment.
+    */
+   OutputFragment take();
+
+protected:
+   int_type overflow( int_type c ) override;
+   std::streamsize xsputn( const char* s, std::streamsize n ) override;
+
+private:
+   /**
+    * \brief Start a new chunk with room for the unfinished fragment and the given number of bytes.
+    */
+   void grow( std::size_t required );
+
+   std::vector<std::unique_ptr<char[]>> chunks_;
+   std::size_t nextChunkSize_ = std::size_t( 1 ) << 16;
+   char* fragmentBegin_ = nullptr;
+};
+
+/**
+ * \brief Output stream writing to its own OutputBuffer.
+ */
+class OutputStream : public std::ostream {
+public:
+   OutputStream() : std::ostream( nullptr ) {
+      rdbuf( &buffer_ );
+   }
+
+   /**
+    * \brief Get everything written since the last call as a fragment.
+    */
+   OutputFragment take() {
+      return buffer_.take();
+   }
+
+private:
+   OutputBuffer buffer_;
+};
+
+/**
+ * \brief Write the fragments in order to a stream.
+ */
+void write_fragments( std::ostream& out, const std::vector<OutputFragment>& fragments );
+
+}
+
+#endif
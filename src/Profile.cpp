@@ -0,0 +1,112 @@
+#include <ctime>
+#include <sys/resource.h>
+#include "Profile.hpp"
+
+namespace gams
+{
+
+thread_local std::uint64_t allocation_count = 0;
+thread_local std::uint64_t allocated_bytes = 0;
+
+static double get_seconds( clockid_t clock )
+{
+   timespec time;
+   clock_gettime( clock, &time );
+   return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+Profile::Phase::Phase( Profile* profile, std::string name ) : profile_( profile )
+{
+   start( std::move( name ) );
+}
+
+Profile::Phase::~Phase()
+{
+   stop();
+}
+
+void Profile::Phase::next( std::string name )
+{
+   stop();
+   start( std::move( name ) );
+}
+
+void Profile::Phase::start( std::string name )
+{
+   if( !profile_ )
+      return;
+
+   data_ = PhaseData();
+   data_.name = std::move( name );
+   running_ = true;
+   allocationsStart_ = allocation_count;
+   allocatedBytesStart_ = allocated_bytes;
+   visitsStart_ = profile_->visits;
+   cpuStart_ = get_seconds( CLOCK_THREAD_CPUTIME_ID );
+   wallStart_ = get_seconds( CLOCK_MONOTONIC );
+}
+
+void Profile::Phase::stop()
+{
+   if( !running_ )
+      return;
+
+   data_.wallSeconds = get_seconds( CLOCK_MONOTONIC ) - wallStart_;
+   data_.cpuSeconds = get_seconds( CLOCK_THREAD_CPUTIME_ID ) - cpuStart_;
+   data_.allocations = allocation_count - allocationsStart_;
+   data_.allocatedBytes = allocated_bytes - allocatedBytesStart_;
+   data_.nodesVisited = profile_->visits - visitsStart_;
+
+   rusage usage;
+
+   if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+      data_.peakRss = usage.ru_maxrss;
+
+   profile_->phases_.push_back( std::move( data_ ) );
+   running_ = false;
+}
+
+void Profile::count( const std::string& counter, std::uint64_t value )
+{
+   counters_[counter] += value;
+}
+
+void Profile::maximize( const std::string& counter, std::uint64_t value )
+{
+   std::uint64_t& current = counters_[counter];
+
+   if( current < value )
+      current = value;
+}
+
+void Profile::writeJson( std::ostream& out ) const
+{
+   //the names of the phases and counters are identifiers, so they need no escaping
+   out << "{\n  \"phases\": [";
+
+   for( std::size_t i = 0; i < phases_.size(); ++i )
+   {
+      const PhaseData& phase = phases_[i];
+      out << ( i == 0 ? "\n" : ",\n" )
+          << "    { \"name\": \"" << phase.name << "\""
+          << ", \"wall_seconds\": " << phase.wallSeconds
+          << ", \"cpu_seconds\": " << phase.cpuSeconds
+          << ", \"peak_rss_kb\": " << phase.peakRss
+          << ", \"allocations\": " << phase.allocations
+          << ", \"allocated_bytes\": " << phase.allocatedBytes
+          << ", \"nodes_visited\": " << phase.nodesVisited << " }";
+   }
+
+   out << "\n  ],\n  \"counters\": {";
+   bool first = true;
+
+   for( auto& counter : counters_ )
+   {
+      out << ( first ? "\n" : ",\n" ) << "    \"" << counter.first << "\": " << counter.second;
+      first = false;
+   }
+
+   out << "\n  }\n}\n";
+}
+
+}
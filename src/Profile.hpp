@@ -0,0 +1,107 @@
+#ifndef _GAMS_PROFILE_HPP_
+#define _GAMS_PROFILE_HPP_
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gams {
+
+/**
+ * \brief Number and bytes of the allocations of the current thread.
+ *
+ * They are only counted in programs that link AllocationCounting.cpp, which replaces the global
+ * operator new. The library does not replace it, so that it leaves the allocator of the programs
+ * embedding it alone.
+ */
+extern thread_local std::uint64_t allocation_count;
+extern thread_local std::uint64_t allocated_bytes;
+
+/**
+ * \brief Resource usage of the phases of a conversion and counters of the work done in them.
+ *
+ * The allocations are counted for each thread, so a profile only measures the allocations
+ * of the thread that runs the phases.
+ */
+class Profile {
+public:
+   /**
+    * \brief Measurements of one phase.
+    */
+   struct PhaseData {
+      std::string name;
+      double wallSeconds = 0.;
+      double cpuSeconds = 0.; //< cpu time of the thread running the phase
+      long peakRss = 0; //< peak resident set size of the process in kilobytes at the end of the phase
+      std::uint64_t allocations = 0;
+      std::uint64_t allocatedBytes = 0;
+      std::uint64_t nodesVisited = 0; //< number of nodes visited by the passes over the graph
+   };
+
+   /**
+    * \brief Measures a phase from its construction until its destruction or the start of the next phase.
+    *
+    * The phase does nothing if the profile is nullptr, so that it can be used unconditionally.
+    */
+   class Phase {
+   public:
+      Phase( Profile* profile, std::string name );
+      ~Phase();
+
+      Phase( const Phase& ) = delete;
+      Phase& operator=( const Phase& ) = delete;
+
+      /**
+       * \brief End this phase and start a phase with the given name.
+       */
+      void next( std::string name );
+
+   private:
+      void start( std::string name );
+      void stop();
+
+      Profile* profile_;
+      PhaseData data_;
+      double wallStart_;
+      double cpuStart_;
+      std::uint64_t allocationsStart_;
+      std::uint64_t allocatedBytesStart_;
+      std::uint64_t visitsStart_;
+      bool running_ = false;
+   };
+
+   /**
+    * \brief Add to a counter.
+    */
+   void count( const std::string& counter, std::uint64_t value );
+
+   /**
+    * \brief Raise a counter to the given value if it is smaller.
+    */
+   void maximize( const std::string& counter, std::uint64_t value );
+
+   const std::vector<PhaseData>& getPhases() const {
+      return phases_;
+   }
+
+   const std::map<std::string, std::uint64_t>& getCounters() const {
+      return counters_;
+   }
+
+   /**
+    * \brief Write the phases and counters as a json object.
+    */
+   void writeJson( std::ostream& out ) const;
+
+   std::uint64_t visits = 0; //< incremented by the passes over the graph for each visited node
+
+private:
+   std::vector<PhaseData> phases_;
+   std::map<std::string, std::uint64_t> counters_;
+};
+
+}
+
+#endif
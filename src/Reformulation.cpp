@@ -0,0 +1,466 @@
+#include <algorithm>
+#include <stack>
+#include "GamsGenerator.hpp"
+#include "NodeChildren.hpp"
+
+namespace gams
+{
+
+Reformulation GamsGenerator::getReformulation( ExpressionGraph::Op op ) const
+{
+   switch( op )
+   {
+   case ExpressionGraph::ABS:
+      return reformulations_[int( NonsmoothClass::ABS )];
+
+   case ExpressionGraph::MIN:
+   case ExpressionGraph::MAX:
+      return reformulations_[int( NonsmoothClass::MINMAX )];
+
+   case ExpressionGraph::G:
+   case ExpressionGraph::GE:
+   case ExpressionGraph::L:
+   case ExpressionGraph::LE:
+   case ExpressionGraph::EQ:
+   case ExpressionGraph::NEQ:
+   case ExpressionGraph::AND:
+   case ExpressionGraph::OR:
+   case ExpressionGraph::NOT:
+      return reformulations_[int( NonsmoothClass::CONDITION )];
+
+   default:
+      return Reformulation::DIRECT;
+   }
+}
+
+bool GamsGenerator::hasBigMFormulation( ExpressionGraph::Op op ) const
+{
+   if( getReformulation( op ) != Reformulation::BIGM )
+      return false;
+
+   switch( op )
+   {
+   case ExpressionGraph::ABS:
+   case ExpressionGraph::MIN:
+   case ExpressionGraph::MAX:
+   case ExpressionGraph::G:
+   case ExpressionGraph::GE:
+   case ExpressionGraph::L:
+   case ExpressionGraph::LE:
+      return true;
+
+   default:
+      return false;
+   }
+}
+
+const char* GamsGenerator::getSmoothPattern( ExpressionGraph::Op op ) const
+{
+   Reformulation reformulation = getReformulation( op );
+
+   //logical operators are exact on the binary variables of the big-M formulation
+   switch( op )
+   {
+   case ExpressionGraph::AND:
+      return reformulation == Reformulation::DIRECT ? nullptr : "((\1)*(\2))";
+
+   case ExpressionGraph::OR:
+      return reformulation == Reformulation::DIRECT ? nullptr : "((\1)+(\2)-(\1)*(\2))";
+
+   case ExpressionGraph::NOT:
+      return reformulation == Reformulation::DIRECT ? nullptr : "(1-(\1))";
+
+   default:
+      break;
+   }
+
+   if( reformulation != Reformulation::SMOOTH )
+      return nullptr;
+
+   switch( op )
+   {
+   case ExpressionGraph::ABS:
+      return "sqrt(sqr(\1)+SMOOTHING)";
+
+   case ExpressionGraph::MAX:
+      return "(((\1)+(\2)+sqrt(sqr((\1)-(\2))+SMOOTHING))/2)";
+
+   case ExpressionGraph::MIN:
+      return "(((\1)+(\2)-sqrt(sqr((\1)-(\2))+SMOOTHING))/2)";
+
+   case ExpressionGraph::G:
+   case ExpressionGraph::GE:
+      return "(0.5+0.5*((\1)-(\2))/sqrt(sqr((\1)-(\2))+SMOOTHING))";
+
+   case ExpressionGraph::L:
+   case ExpressionGraph::LE:
+      return "(0.5+0.5*((\2)-(\1))/sqrt(sqr((\2)-(\1))+SMOOTHING))";
+
+   case ExpressionGraph::EQ:
+      return "(SMOOTHING/(sqr((\1)-(\2))+SMOOTHING))";
+
+   case ExpressionGraph::NEQ:
+      return "(1-SMOOTHING/(sqr((\1)-(\2))+SMOOTHING))";
+
+   default:
+      return nullptr;
+   }
+}
+
+void GamsGenerator::indexBigMFormulations()
+{
+   bigmIds_.clear();
+
+   if( std::find( reformulations_.begin(), reformulations_.end(), Reformulation::BIGM ) == reformulations_.end() )
+      return;
+
+   std::stack<ExpressionGraph::Node*> stack;
+   std::unordered_set<ExpressionGraph::Node*> nodes;
+
+   for( auto & entry : getSymbolTable() )
+   {
+      if( isLive( entry.second ) )
+         stack.push( entry.second );
+   }
+
+   while( !stack.empty() )
+   {
+      ExpressionGraph::Node* top = stack.top();
+      stack.pop();
+      countVisit();
+
+      if( top->type != ExpressionGraph::DYNAMIC_NODE || !nodes.insert( top ).second )
+         continue;
+
+      if( hasBigMFormulation( top->op ) )
+         bigmIds_.emplace( top, bigmIds_.size() + 1 );
+
+      //only values that are not translated as initial values are reformulated
+      switch( top->op )
+      {
+      case ExpressionGraph::INITIAL:
+         continue;
+
+      case ExpressionGraph::INTEG:
+      case ExpressionGraph::ACTIVE_INITIAL:
+      case ExpressionGraph::DELAY_FIXED:
+         stack.push( top->child1 );
+         continue;
+
+      default:
+      {
+         ExpressionGraph::Node* children[3];
+         int n = get_children( top, children );
+
+         for( int i = 0; i < n; ++i )
+            stack.push( children[i] );
+      }
+      }
+   }
+}
+
+double GamsGenerator::getBigM( ExpressionGraph::Node* node )
+{
+   FlatGraph::Index index = flat_.getIndex( node );
+   Interval bounds = getBounds( flat_.getChild1( index ) );
+
+   if( node->op != ExpressionGraph::ABS )
+      bounds = bounds - getBounds( flat_.getChild2( index ) );
+
+   return bounds.bounded() ? bounds.magnitude() : bigM_;
+}
+
+Interval GamsGenerator::getBounds( FlatGraph::Index index )
+{
+   //nodes appended to the snapshot after the last call have no entries yet
+   if( static_cast<std::size_t>( index ) >= boundsKnown_.size() )
+   {
+      bounds_.resize( flat_.size() );
+      boundsKnown_.resize( flat_.size(), false );
+   }
+
+   if( boundsKnown_[index] )
+      return bounds_[index];
+
+   //nodes are unbounded while they are evaluated, so that cycles terminate
+   boundsKnown_[index] = true;
+   ExpressionGraph::Node* node = flat_.getNode( index );
+   Interval result;
+
+   if( flat_.getType( index ) == ExpressionGraph::CONSTANT_NODE && !isScenarioNode( node ) )
+   {
+      result = Interval( flat_.getValue( index ) );
+   }
+   else
+   {
+      auto column = !flat_.hasSymbol( index ) ? scenarios_.constants.end() : std::find( scenarios_.constants.begin(), scenarios_.constants.end(), flat_.getSymbol( index ) );
+
+      if( column != scenarios_.constants.end() )
+      {
+         std::size_t j = column - scenarios_.constants.begin();
+         result = Interval( scenarios_.values.front()[j] );
+
+         for( const std::vector<double>& values : scenarios_.values )
+            result = hull( result, Interval( values[j] ) );
+      }
+      else
+      {
+         switch( flat_.getOp( index ) )
+         {
+         case ExpressionGraph::CONSTANT:
+            result = Interval( flat_.getValue( index ) );
+            break;
+
+         case ExpressionGraph::TIME:
+            result = Interval( getNode( Symbol( "INITIAL TIME" ) )->value, getNode( Symbol( "FINAL TIME" ) )->value );
+            break;
+
+         case ExpressionGraph::CONTROL:
+         {
+            FlatGraph::Index lower = flat_.getChild1( index );
+            FlatGraph::Index upper = flat_.getChild3( index );
+            result = Interval( lower != FlatGraph::NONE ? flat_.getValue( lower ) : result.lo, upper != FlatGraph::NONE ? flat_.getValue( upper ) : result.hi );
+            break;
+         }
+
+         case ExpressionGraph::PLUS:
+            result = getBounds( flat_.getChild1( index ) ) + getBounds( flat_.getChild2( index ) );
+            break;
+
+         case ExpressionGraph::MINUS:
+            result = getBounds( flat_.getChild1( index ) ) - getBounds( flat_.getChild2( index ) );
+            break;
+
+         case ExpressionGraph::UMINUS:
+            result = -getBounds( flat_.getChild1( index ) );
+            break;
+
+         case ExpressionGraph::MULT:
+            result = getBounds( flat_.getChild1( index ) ) * getBounds( flat_.getChild2( index ) );
+            break;
+
+         case ExpressionGraph::DIV:
+            result = getBounds( flat_.getChild1( index ) ) / getBounds( flat_.getChild2( index ) );
+            break;
+
+         case ExpressionGraph::ABS:
+            result = abs( getBounds( flat_.getChild1( index ) ) );
+            break;
+
+         case ExpressionGraph::MIN:
+            result = min( getBounds( flat_.getChild1( index ) ), getBounds( flat_.getChild2( index ) ) );
+            break;
+
+         case ExpressionGraph::MAX:
+            result = max( getBounds( flat_.getChild1( index ) ), getBounds( flat_.getChild2( index ) ) );
+            break;
+
+         case ExpressionGraph::POWER:
+         {
+            Interval base = getBounds( flat_.getChild1( index ) );
+            Interval exponent = getBounds( flat_.getChild2( index ) );
+
+            if( exponent.lo == 2. && exponent.hi == 2. )
+               result = sqr( base );
+            else if( exponent.lo == 1. && exponent.hi == 1. )
+               result = base;
+            else if( base.lo >= 0. && exponent.lo == exponent.hi && exponent.lo > 0. )
+               result = Interval( std::pow( base.lo, exponent.lo ), std::pow( base.hi, exponent.lo ) );
+
+            break;
+         }
+
+         case ExpressionGraph::SQRT:
+         {
+            Interval arg = getBounds( flat_.getChild1( index ) );
+
+            if( arg.lo >= 0. )
+               result = Interval( std::sqrt( arg.lo ), std::sqrt( arg.hi ) );
+
+            break;
+         }
+
+         case ExpressionGraph::EXP:
+         {
+            Interval arg = getBounds( flat_.getChild1( index ) );
+            result = Interval( std::exp( arg.lo ), std::exp( arg.hi ) );
+            break;
+         }
+
+         case ExpressionGraph::LN:
+         {
+            Interval arg = getBounds( flat_.getChild1( index ) );
+
+            if( arg.lo > 0. )
+               result = Interval( std::log( arg.lo ), std::log( arg.hi ) );
+
+            break;
+         }
+
+         case ExpressionGraph::INTEGER:
+         {
+            Interval arg = getBounds( flat_.getChild1( index ) );
+            result = Interval( std::floor( arg.lo ), std::floor( arg.hi ) );
+            break;
+         }
+
+         case ExpressionGraph::SIN:
+         case ExpressionGraph::COS:
+         case ExpressionGraph::TANH:
+            result = Interval( -1., 1. );
+            break;
+
+         case ExpressionGraph::ARCTAN:
+            result = Interval( -std::atan( 1. ) * 2., std::atan( 1. ) * 2. );
+            break;
+
+         case ExpressionGraph::G:
+         case ExpressionGraph::GE:
+         case ExpressionGraph::L:
+         case ExpressionGraph::LE:
+         case ExpressionGraph::EQ:
+         case ExpressionGraph::NEQ:
+         case ExpressionGraph::AND:
+         case ExpressionGraph::OR:
+         case ExpressionGraph::NOT:
+         case ExpressionGraph::PULSE:
+         case ExpressionGraph::PULSE_TRAIN:
+            result = Interval( 0., 1. );
+            break;
+
+         case ExpressionGraph::IF:
+            result = hull( getBounds( flat_.getChild2( index ) ), getBounds( flat_.getChild3( index ) ) );
+            break;
+
+         case ExpressionGraph::STEP:
+            result = hull( Interval( 0. ), getBounds( flat_.getChild1( index ) ) );
+            break;
+
+         case ExpressionGraph::INITIAL:
+            result = getBounds( flat_.getChild1( index ) );
+            break;
+
+         case ExpressionGraph::ACTIVE_INITIAL:
+            result = hull( getBounds( flat_.getChild1( index ) ), getBounds( flat_.getChild2( index ) ) );
+            break;
+
+         case ExpressionGraph::DELAY_FIXED:
+            result = hull( getBounds( flat_.getChild1( index ) ), getBounds( flat_.getChild3( index ) ) );
+            break;
+
+         case ExpressionGraph::APPLY_LOOKUP:
+         {
+            //lookups are constant outside of their points
+            const std::vector<double>& yvals = node->child1->lookup_table->getYvals();
+
+            if( !yvals.empty() )
+               result = Interval( *std::min_element( yvals.begin(), yvals.end() ), *std::max_element( yvals.begin(), yvals.end() ) );
+
+            break;
+         }
+
+         default:
+            break;
+         }
+      }
+   }
+
+   bounds_[index] = result;
+   return result;
+}
+
+void GamsGenerator::createBigMFormulation( ExpressionGraph::Node* node, int id, std::ostream& variables, std::ostream& declarations, std::ostream& definitions )
+{
+   std::string sets = getVarSets( node );
+   std::string stage = getStageCondition();
+   std::string var = "bigm" + std::to_string( id );
+   std::string z = var + "_z(" + sets + ")";
+   std::string m = format_double( getBigM( node ), digits_ );
+
+   variables << "Binary Variable " << var << "_z(" << sets << ");\n";
+
+   switch( node->op )
+   {
+   case ExpressionGraph::ABS:
+      //split the argument into its positive and negative part
+      variables << "Positive Variable " << var << "_pos(" << sets << ");\n"
+                << "Positive Variable " << var << "_neg(" << sets << ");\n";
+      declarations << "Equation eq_" << var << "_split(" << sets << ");\n"
+                   << "Equation eq_" << var << "_pos(" << sets << ");\n"
+                   << "Equation eq_" << var << "_neg(" << sets << ");\n";
+      definitions << "eq_" << var << "_split(" << sets << ")" << stage << " ..\n\t";
+      translate( definitions, node->child1, false );
+      definitions << " =e= " << var << "_pos(" << sets << ")-" << var << "_neg(" << sets << ");\n";
+      definitions << "eq_" << var << "_pos(" << sets << ")" << stage << " ..\n\t" << var << "_pos(" << sets << ") =l= " << m << "*" << z << ";\n";
+      definitions << "eq_" << var << "_neg(" << sets << ")" << stage << " ..\n\t" << var << "_neg(" << sets << ") =l= " << m << "*(1-" << z << ");\n";
+      break;
+
+   case ExpressionGraph::MIN:
+   case ExpressionGraph::MAX:
+   {
+      //the variable is bounded by both arguments and equal to the one selected by the binary variable
+      bool max = node->op == ExpressionGraph::MAX;
+      const char* bound = max ? " =g= " : " =l= ";
+      const char* select = max ? " =l= " : " =g= ";
+      const char* sign = max ? "+" : "-";
+      variables << "Variable " << var << "(" << sets << ");\n";
+
+      for( int i = 1; i <= 2; ++i )
+      {
+         ExpressionGraph::Node* arg = i == 1 ? node->child1 : node->child2;
+         declarations << "Equation eq_" << var << "_" << i << "(" << sets << ");\n"
+                      << "Equation eq_" << var << "_" << i << "z(" << sets << ");\n";
+         definitions << "eq_" << var << "_" << i << "(" << sets << ")" << stage << " ..\n\t" << var << "(" << sets << ")" << bound;
+         translate( definitions, arg, false );
+         definitions << ";\n";
+         definitions << "eq_" << var << "_" << i << "z(" << sets << ")" << stage << " ..\n\t" << var << "(" << sets << ")" << select;
+         translate( definitions, arg, false );
+         definitions << sign << m << "*" << ( i == 1 ? "(1-" + z + ")" : z ) << ";\n";
+      }
+
+      break;
+   }
+
+   default:
+   {
+      //the binary variable is one if the difference is positive and zero if it is negative
+      bool greater = node->op == ExpressionGraph::G || node->op == ExpressionGraph::GE;
+      ExpressionGraph::Node* a = greater ? node->child1 : node->child2;
+      ExpressionGraph::Node* b = greater ? node->child2 : node->child1;
+      declarations << "Equation eq_" << var << "_on(" << sets << ");\n"
+                   << "Equation eq_" << var << "_off(" << sets << ");\n";
+      definitions << "eq_" << var << "_on(" << sets << ")" << stage << " ..\n\t";
+      translate( definitions, a, false );
+      definitions << "-(";
+      translate( definitions, b, false );
+      definitions << ") =l= " << m << "*" << z << ";\n";
+      definitions << "eq_" << var << "_off(" << sets << ")" << stage << " ..\n\t";
+      translate( definitions, a, false );
+      definitions << "-(";
+      translate( definitions, b, false );
+      definitions << ") =g= -" << m << "*(1-" << z << ");\n";
+   }
+   }
+}
+
+void GamsGenerator::translateBigM( std::ostream& stream, ExpressionGraph::Node* node, int id )
+{
+   std::string sets = getVarSets( node );
+
+   switch( node->op )
+   {
+   case ExpressionGraph::ABS:
+      stream << "(bigm" << id << "_pos(" << sets << ")+bigm" << id << "_neg(" << sets << "))";
+      break;
+
+   case ExpressionGraph::MIN:
+   case ExpressionGraph::MAX:
+      stream << "bigm" << id << "(" << sets << ")";
+      break;
+
+   default:
+      stream << "bigm" << id << "_z(" << sets << ")";
+   }
+}
+
+}
@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <cmath>
+#include "GamsGenerator.hpp"
+
+namespace gams
+{
+
+/**
+ * Smallest and largest exponent of the power of ten used as scale. Magnitudes below the
+ * lower limit are usually numerical zeros.
+ */
+static const int MIN_SCALE_EXPONENT = -6;
+static const int MAX_SCALE_EXPONENT = 9;
+
+double GamsGenerator::evaluate( FlatGraph::Index index, double time, std::vector<double>& values, std::vector<char>& known ) const
+{
+   countVisit();
+
+   if( flat_.getType( index ) == ExpressionGraph::CONSTANT_NODE )
+      return flat_.getValue( index );
+
+   if( known[index] )
+      return values[index];
+
+   //nodes in algebraic loops use their initial value when they are reached again
+   known[index] = true;
+   values[index] = flat_.getValue( index );
+   double value;
+
+   switch( flat_.getOp( index ) )
+   {
+   case ExpressionGraph::TIME:
+      value = time;
+      break;
+
+   case ExpressionGraph::CONTROL:
+      value = flat_.getValue( flat_.getChild2( index ) != FlatGraph::NONE ? flat_.getChild2( index ) : index );
+      break;
+
+   case ExpressionGraph::ACTIVE_INITIAL:
+      value = evaluate( flat_.getChild1( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::DELAY_FIXED:
+      //the history of the input is not stored, so the current input is used after the delay time
+      if( time < getNode( Symbol( "INITIAL TIME" ) )->value + evaluate( flat_.getChild2( index ), time, values, known ) )
+         value = evaluate( flat_.getChild3( index ), time, values, known );
+      else
+         value = evaluate( flat_.getChild1( index ), time, values, known );
+
+      break;
+
+   case ExpressionGraph::IF:
+      if( evaluate( flat_.getChild1( index ), time, values, known ) != 0. )
+         value = evaluate( flat_.getChild2( index ), time, values, known );
+      else
+         value = evaluate( flat_.getChild3( index ), time, values, known );
+
+      break;
+
+   case ExpressionGraph::PULSE:
+   {
+      double start = evaluate( flat_.getChild1( index ), time, values, known );
+      value = time >= start && time < start + evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+   }
+
+   case ExpressionGraph::PULSE_TRAIN:
+   {
+      double start = evaluate( flat_.getChild1( flat_.getChild1( index ) ), time, values, known );
+      double phase = std::fmod( time, evaluate( flat_.getChild2( index ), time, values, known ) );
+      value = phase >= start && phase < start + evaluate( flat_.getChild2( flat_.getChild1( index ) ), time, values, known )
+              && time < evaluate( flat_.getChild3( index ), time, values, known );
+      break;
+   }
+
+   case ExpressionGraph::STEP:
+      value = time >= evaluate( flat_.getChild2( index ), time, values, known ) ? evaluate( flat_.getChild1( index ), time, values, known ) : 0.;
+      break;
+
+   case ExpressionGraph::RAMP:
+   {
+      double start = evaluate( flat_.getChild2( index ), time, values, known );
+      double end = evaluate( flat_.getChild3( index ), time, values, known );
+      value = time > start ? evaluate( flat_.getChild1( index ), time, values, known ) * ( std::min( time, end ) - start ) : 0.;
+      break;
+   }
+
+   case ExpressionGraph::RANDOM_UNIFORM:
+      value = ( evaluate( flat_.getChild1( index ), time, values, known ) + evaluate( flat_.getChild2( index ), time, values, known ) ) / 2.;
+      break;
+
+   case ExpressionGraph::APPLY_LOOKUP:
+      value = ( *flat_.getNode( index )->child1->lookup_table )( evaluate( flat_.getChild2( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::ABS:
+      value = std::fabs( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::SIN:
+      value = std::sin( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::COS:
+      value = std::cos( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::TAN:
+      value = std::tan( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::ARCSIN:
+      value = std::asin( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::ARCCOS:
+      value = std::acos( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::ARCTAN:
+      value = std::atan( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::SINH:
+      value = std::sinh( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::COSH:
+      value = std::cosh( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::TANH:
+      value = std::tanh( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::EXP:
+      value = std::exp( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::INTEGER:
+      value = std::trunc( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::LN:
+      value = std::log( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::UMINUS:
+      value = -evaluate( flat_.getChild1( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::NOT:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) == 0.;
+      break;
+
+   case ExpressionGraph::SQRT:
+      value = std::sqrt( evaluate( flat_.getChild1( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::PLUS:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) + evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::MINUS:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) - evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::MULT:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) * evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::DIV:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) / evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::AND:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) != 0. && evaluate( flat_.getChild2( index ), time, values, known ) != 0.;
+      break;
+
+   case ExpressionGraph::OR:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) != 0. || evaluate( flat_.getChild2( index ), time, values, known ) != 0.;
+      break;
+
+   case ExpressionGraph::L:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) < evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::LE:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) <= evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::G:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) > evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::GE:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) >= evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::EQ:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) == evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::NEQ:
+      value = evaluate( flat_.getChild1( index ), time, values, known ) != evaluate( flat_.getChild2( index ), time, values, known );
+      break;
+
+   case ExpressionGraph::LOG:
+      value = std::log( evaluate( flat_.getChild1( index ), time, values, known ) ) / std::log( evaluate( flat_.getChild2( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::POWER:
+      value = std::pow( evaluate( flat_.getChild1( index ), time, values, known ), evaluate( flat_.getChild2( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::MIN:
+      value = std::min( evaluate( flat_.getChild1( index ), time, values, known ), evaluate( flat_.getChild2( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::MAX:
+      value = std::max( evaluate( flat_.getChild1( index ), time, values, known ), evaluate( flat_.getChild2( index ), time, values, known ) );
+      break;
+
+   case ExpressionGraph::MODULO:
+      value = std::fmod( evaluate( flat_.getChild1( index ), time, values, known ), evaluate( flat_.getChild2( index ), time, values, known ) );
+      break;
+
+   //states are known in each step, initial values are computed by the analysis of the graph
+   default:
+      value = flat_.getValue( index );
+   }
+
+   values[index] = value;
+   return value;
+}
+
+void GamsGenerator::estimateMagnitudes()
+{
+   magnitudes_.clear();
+
+   if( !scaling_ )
+      return;
+
+   std::vector<FlatGraph::Index> states;
+   std::vector<std::pair<int, FlatGraph::Index>> nodes;
+
+   for( auto & entry : getSymbolTable() )
+   {
+      ExpressionGraph::Node* node = entry.second;
+
+      if( node->type != ExpressionGraph::DYNAMIC_NODE || node->op == ExpressionGraph::CONTROL )
+         continue;
+
+      FlatGraph::Index index = flat_.getIndex( node );
+
+      if( node->op == ExpressionGraph::INTEG )
+         states.push_back( index );
+      else
+         nodes.emplace_back( node->level, index );
+   }
+
+   //evaluate the symbols in order of their dependencies to keep the recursion shallow
+   std::stable_sort( nodes.begin(), nodes.end(), []( const std::pair<int, FlatGraph::Index>& a, const std::pair<int, FlatGraph::Index>& b )
+   {
+      return a.first < b.first;
+   } );
+
+   double final_time = getNode( Symbol( "FINAL TIME" ) )->value;
+   double initial_time = getNode( Symbol( "INITIAL TIME" ) )->value;
+   double time_step = getNode( Symbol( "TIME STEP" ) )->value;
+   long steps = std::lround( ( final_time - initial_time ) / time_step );
+
+   //forward simulation with the explicit euler method starting from the initial values
+   std::vector<double> stateValues;
+   std::vector<double> derivatives( states.size() );
+
+   for( FlatGraph::Index state : states )
+      stateValues.push_back( flat_.getValue( state ) );
+
+   //the snapshot is complete here, as the symbols above were appended if they were missing,
+   //and the nodes that are not symbols keep a negative magnitude
+   magnitudes_.assign( flat_.size(), -1. );
+
+   for( FlatGraph::Index state : states )
+      magnitudes_[state] = 0.;
+
+   for( auto & entry : nodes )
+      magnitudes_[entry.second] = 0.;
+
+   std::vector<double> values( flat_.size() );
+   std::vector<char> known( flat_.size() );
+
+   for( long k = 0; k <= steps; ++k )
+   {
+      double time = initial_time + k * time_step;
+      std::fill( known.begin(), known.end(), false );
+
+      for( std::size_t i = 0; i < states.size(); ++i )
+      {
+         values[states[i]] = stateValues[i];
+         known[states[i]] = true;
+      }
+
+      for( auto & entry : nodes )
+         evaluate( entry.second, time, values, known );
+
+      for( std::size_t i = 0; i < states.size(); ++i )
+         derivatives[i] = evaluate( flat_.getChild1( states[i] ), time, values, known );
+
+      for( std::size_t i = 0; i < magnitudes_.size(); ++i )
+      {
+         double value = std::fabs( values[i] );
+
+         if( magnitudes_[i] >= 0. && std::isfinite( value ) )
+            magnitudes_[i] = std::max( magnitudes_[i], value );
+      }
+
+      for( std::size_t i = 0; i < states.size(); ++i )
+         stateValues[i] += time_step * derivatives[i];
+   }
+}
+
+double GamsGenerator::getScale( ExpressionGraph::Node* node ) const
+{
+   FlatGraph::Index index = flat_.findIndex( node );
+
+   if( index == FlatGraph::NONE || static_cast<std::size_t>( index ) >= magnitudes_.size() || !( magnitudes_[index] > 0. ) )
+      return 1.;
+
+   //powers of ten do not introduce rounding errors into the scaled values
+   long exponent = std::lround( std::log10( magnitudes_[index] ) );
+   exponent = std::max<long>( MIN_SCALE_EXPONENT, std::min<long>( MAX_SCALE_EXPONENT, exponent ) );
+   return std::pow( 10., exponent );
+}
+
+void GamsGenerator::emitScales( std::ostream& variables, std::ostream& equations, ExpressionGraph::Node* node, const std::string& var, const std::string& prefix )
+{
+   double scale = getScale( node );
+
+   if( scale == 1. )
+      return;
+
+   std::string value = format_double( scale, digits_ );
+
+   //the residual of each equation is in the units of the variable it defines
+   variables << var << ".scale(" << prefix << getVarSets() << ") = " << value << ";\n";
+   equations << "eq_" << var << ".scale(" << prefix << getVarSets() << ") = " << value << ";\n";
+
+   if( node->op != ExpressionGraph::INTEG )
+      return;
+
+   if( staged_ )
+      equations << "eq_" << var << "IntegStep.scale(" << prefix << getVarSets() << ") = " << value << ";\n";
+
+   if( node->init != ExpressionGraph::CONSTANT_INIT )
+   {
+      std::string index = prefix.empty() ? "" : "(" + prefix.substr( 0, prefix.size() - 2 ) + ")";
+      equations << "eq_" << var << "Init.scale" << index << " = " << value << ";\n";
+   }
+}
+
+}
@@ -0,0 +1,85 @@
+#include <fstream>
+#include <stdexcept>
+#include <boost/tokenizer.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/lexical_cast.hpp>
+#include "Scenarios.hpp"
+
+namespace gams
+{
+
+static std::vector<std::string> split_csv_line( const std::string& line )
+{
+   typedef boost::tokenizer<boost::escaped_list_separator<char>> Tokenizer;
+   std::vector<std::string> fields;
+
+   for( std::string field : Tokenizer( line ) )
+   {
+      boost::algorithm::trim( field );
+      fields.push_back( std::move( field ) );
+   }
+
+   return fields;
+}
+
+ScenarioTable parse_scenario_file( const std::string& filename )
+{
+   std::ifstream file( filename );
+
+   if( !file.good() )
+      throw std::runtime_error( "cannot read scenario file '" + filename + "'" );
+
+   ScenarioTable table;
+   std::string line;
+   int lineNumber = 0;
+
+   while( std::getline( file, line ) )
+   {
+      ++lineNumber;
+      boost::algorithm::trim( line );
+
+      if( line.empty() )
+         continue;
+
+      std::vector<std::string> fields = split_csv_line( line );
+
+      if( table.constants.empty() )
+      {
+         if( fields.size() < 2 )
+            throw std::runtime_error( filename + ":" + std::to_string( lineNumber ) + ": header must name at least one constant" );
+
+         for( std::size_t i = 1; i < fields.size(); ++i )
+            table.constants.emplace_back( fields[i] );
+
+         continue;
+      }
+
+      if( fields.size() != table.constants.size() + 1 )
+         throw std::runtime_error( filename + ":" + std::to_string( lineNumber ) + ": expected "
+                                   + std::to_string( table.constants.size() + 1 ) + " fields" );
+
+      std::vector<double> values;
+
+      for( std::size_t i = 1; i < fields.size(); ++i )
+      {
+         try
+         {
+            values.push_back( boost::lexical_cast<double>( fields[i] ) );
+         }
+         catch( const boost::bad_lexical_cast& )
+         {
+            throw std::runtime_error( filename + ":" + std::to_string( lineNumber ) + ": '" + fields[i] + "' is not a number" );
+         }
+      }
+
+      table.names.push_back( fields.front() );
+      table.values.push_back( std::move( values ) );
+   }
+
+   if( table.empty() )
+      throw std::runtime_error( "scenario file '" + filename + "' does not contain any scenario" );
+
+   return table;
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef _GAMS_SCENARIOS_HPP_
+#define _GAMS_SCENARIOS_HPP_
+
+#include <sdo/ExpressionGraph.hpp>
+#include <vector>
+#include <string>
+
+namespace gams {
+
+/**
+ * \brief Values of a selection of constants for a set of scenarios.
+ *
+ * Each scenario assigns a value to every constant in the table. The GamsGenerator
+ * uses the table to add a scenario set to the constants and all symbols depending on them,
+ * so that all scenarios are solved within a single gams model.
+ */
+struct ScenarioTable {
+   std::vector<std::string> names; //< the names of the scenarios
+   std::vector<sdo::Symbol> constants; //< the constants that have different values in the scenarios
+   std::vector<std::vector<double>> values; //< values[i][j] is the value of constants[j] in the scenario names[i]
+
+   /**
+    * \brief Check if the table contains any scenario.
+    */
+   bool empty() const {
+      return names.empty();
+   }
+};
+
+/**
+ * \brief Read a scenario table from a csv file.
+ *
+ * The first row of the file contains an arbitrary label followed by the names of the constants.
+ * Each following row contains the name of a scenario followed by the values of the constants
+ * in that scenario. Fields can be quoted with '"'.
+ *
+ * \param filename the name of the csv file
+ * \return the parsed scenario table
+ * \throws std::runtime_error if the file cannot be read or is malformed
+ */
+ScenarioTable parse_scenario_file( const std::string& filename );
+
+}
+
+#endif
@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <sdo/Parsers.hpp>
+#include "Server.hpp"
+
+namespace gams
+{
+
+namespace po = boost::program_options;
+
+//requests are small, so longer messages are rejected instead of allocating their size
+static const std::uint32_t MAX_REQUEST_SIZE = 1 << 20;
+
+/**
+ * The identity, times and size of a file, used to detect changes of the files of a parsed graph.
+ * The times have nanoseconds, as a file can be changed twice in a second without changing its
+ * size, and the inode and change time detect files that were replaced by a rename.
+ */
+struct FileStamp {
+   std::string file;
+   long long inode;
+   long long mtime;
+   long long mtimeNsec;
+   long long ctime;
+   long long ctimeNsec;
+   long long size;
+
+   bool operator==( const FileStamp& other ) const {
+      return file == other.file && inode == other.inode && mtime == other.mtime && mtimeNsec == other.mtimeNsec
+             && ctime == other.ctime && ctimeNsec == other.ctimeNsec && size == other.size;
+   }
+};
+
+/**
+ * A graph that is kept in memory between requests. The conversions do not change the graph,
+ * so each request converts the same model as a single run.
+ */
+struct ServedModel {
+   std::mutex mutex; //< held while the graph is parsed or converted, as it is replaced when its files change
+   std::unique_ptr<sdo::ExpressionGraph> exprGraph; //< the parsed graph or nullptr
+   std::vector<FileStamp> stamps; //< the files the graph was parsed from
+};
+
+/**
+ * The state that is shared by the connections.
+ */
+struct ServerState {
+   const po::options_description& desc;
+   ConversionCache* cache;
+   std::ostream& log;
+   std::mutex mutex; //< protects the models and the log
+   std::map<std::pair<std::vector<std::string>, std::vector<std::string>>, std::shared_ptr<ServedModel>> models;
+};
+
+static std::vector<FileStamp> get_stamps( const ConversionInputs& inputs )
+{
+   std::vector<FileStamp> stamps;
+
+   for( const std::vector<std::string>* files : { &inputs.vocFiles, &inputs.mdlFiles } )
+   {
+      for( const std::string& file : *files )
+      {
+         struct stat info;
+
+         if( stat( file.c_str(), &info ) != 0 )
+            throw std::runtime_error( "cannot read file '" + file + "'" );
+
+         stamps.push_back( FileStamp { file, static_cast<long long>( info.st_ino ),
+                                       static_cast<long long>( info.st_mtim.tv_sec ), static_cast<long long>( info.st_mtim.tv_nsec ),
+                                       static_cast<long long>( info.st_ctim.tv_sec ), static_cast<long long>( info.st_ctim.tv_nsec ),
+                                       static_cast<long long>( info.st_size ) } );
+      }
+   }
+
+   return stamps;
+}
+
+/**
+ * Read exactly size bytes from the socket.
+ *
+ * \return false if the connection was closed
+ */
+static bool read_full( int fd, char* data, std::size_t size )
+{
+   while( size > 0 )
+   {
+      ssize_t n = read( fd, data, size );
+
+      if( n < 0 && errno == EINTR )
+         continue;
+
+      if( n <= 0 )
+         return false;
+
+      data += n;
+      size -= n;
+   }
+
+   return true;
+}
+
+static bool write_full( int fd, const char* data, std::size_t size )
+{
+   while( size > 0 )
+   {
+      ssize_t n = send( fd, data, size, MSG_NOSIGNAL );
+
+      if( n < 0 && errno == EINTR )
+         continue;
+
+      if( n <= 0 )
+         return false;
+
+      data += n;
+      size -= n;
+   }
+
+   return true;
+}
+
+static bool write_message( int fd, const std::string& message )
+{
+   std::uint32_t size = htonl( static_cast<std::uint32_t>( message.size() ) );
+   return write_full( fd, reinterpret_cast<const char*>( &size ), sizeof( size ) ) && write_full( fd, message.data(), message.size() );
+}
+
+/**
+ * Convert the request and return the response.
+ */
+static std::string handle_request( ServerState& state, const std::string& message )
+{
+   typedef std::chrono::steady_clock Clock;
+   Clock::time_point start = Clock::now();
+   double parseSeconds = 0.;
+   std::ostringstream gams;
+   std::string error;
+   ConversionRequest request;
+
+   try
+   {
+      request = get_conversion_request( po::split_unix( message ), state.desc );
+
+      std::shared_ptr<ServedModel> model;
+      {
+         std::lock_guard<std::mutex> lock( state.mutex );
+         std::shared_ptr<ServedModel>& entry = state.models[std::make_pair( request.inputs.mdlFiles, request.inputs.vocFiles )];
+
+         if( !entry )
+            entry = std::make_shared<ServedModel>();
+
+         model = entry;
+      }
+
+      std::lock_guard<std::mutex> lock( model->mutex );
+      std::vector<FileStamp> stamps = get_stamps( request.inputs );
+
+      auto graph = [&]() -> sdo::ExpressionGraph&
+      {
+         if( !model->exprGraph || !( model->stamps == stamps ) )
+         {
+            Clock::time_point begin = Clock::now();
+            model->exprGraph.reset( new sdo::ExpressionGraph );
+
+            try
+            {
+               parse_model( request.inputs, *model->exprGraph );
+            }
+            catch( ... )
+            {
+               model->exprGraph.reset();
+               throw;
+            }
+
+            model->stamps = stamps;
+            parseSeconds = std::chrono::duration<double>( Clock::now() - begin ).count();
+         }
+
+         return *model->exprGraph;
+      };
+
+      std::unique_ptr<std::ofstream> file;
+
+      if( !request.outputFile.empty() )
+      {
+         file = std::unique_ptr<std::ofstream> { new std::ofstream( request.outputFile ) };
+
+         if( !file->good() )
+            throw std::runtime_error( "unable to write to file '" + request.outputFile + "'" );
+      }
+
+      std::ostream& out = file ? *file : static_cast<std::ostream&>( gams );
+
+      if( state.cache )
+         convert_cached( *state.cache, graph, request.inputs, request.options, out, request.outputFile );
+      else
+         convert( graph(), request.inputs, request.options, out, request.outputFile );
+   }
+   catch( const sdo::parse_error& err )
+   {
+      error = err.what();
+   }
+   catch( const std::ifstream::failure& err )
+   {
+      error = "cannot read file";
+   }
+   catch( const std::runtime_error& err )
+   {
+      error = err.what();
+   }
+   //the connections run on detached threads, where an exception would terminate the server
+   catch( const std::exception& err )
+   {
+      error = err.what();
+   }
+   catch( ... )
+   {
+      error = "unknown error";
+   }
+
+   double totalSeconds = std::chrono::duration<double>( Clock::now() - start ).count();
+   std::ostringstream response;
+
+   if( error.empty() )
+   {
+      response << "ok parse=" << parseSeconds << " convert=" << totalSeconds - parseSeconds << " total=" << totalSeconds << "\n"
+               << gams.str();
+   }
+   else
+   {
+      //the message is kept on the first line of the response
+      std::replace( error.begin(), error.end(), '\n', ' ' );
+      response << "error " << error << "\n";
+   }
+
+   std::lock_guard<std::mutex> lock( state.mutex );
+   state.log << "serve: '" << message << "' " << ( error.empty() ? "converted" : "failed" )
+             << " in " << totalSeconds << " s, " << parseSeconds << " s parsing\n";
+   return response.str();
+}
+
+/**
+ * Answer the requests of a client until it closes the connection.
+ */
+static void serve_connection( ServerState& state, int fd )
+{
+   while( true )
+   {
+      std::uint32_t size;
+
+      if( !read_full( fd, reinterpret_cast<char*>( &size ), sizeof( size ) ) )
+         break;
+
+      size = ntohl( size );
+
+      if( size > MAX_REQUEST_SIZE )
+      {
+         write_message( fd, "error request too long\n" );
+         break;
+      }
+
+      std::string message( size, '\0' );
+
+      if( !read_full( fd, &message[0], size ) || !write_message( fd, handle_request( state, message ) ) )
+         break;
+   }
+
+   close( fd );
+}
+
+void run_server( const std::string& socketPath, const po::options_description& desc,
+                 ConversionCache* cache, std::ostream& log )
+{
+   sockaddr_un address;
+   std::memset( &address, 0, sizeof( address ) );
+   address.sun_family = AF_UNIX;
+
+   if( socketPath.size() >= sizeof( address.sun_path ) )
+      throw std::runtime_error( "socket path '" + socketPath + "' is too long" );
+
+   std::strcpy( address.sun_path, socketPath.c_str() );
+
+   int listener = socket( AF_UNIX, SOCK_STREAM, 0 );
+
+   if( listener < 0 )
+      throw std::runtime_error( "unable to create socket" );
+
+   //only the stale socket of a server that is no longer running is removed
+   struct stat info;
+
+   if( lstat( socketPath.c_str(), &info ) == 0 )
+   {
+      if( !S_ISSOCK( info.st_mode ) )
+      {
+         close( listener );
+         throw std::runtime_error( "unable to listen on socket '" + socketPath + "': path exists and is not a socket" );
+      }
+
+      int probe = socket( AF_UNIX, SOCK_STREAM, 0 );
+      bool listening = probe >= 0 && connect( probe, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) ) == 0;
+
+      if( probe >= 0 )
+         close( probe );
+
+      if( listening )
+      {
+         close( listener );
+         throw std::runtime_error( "unable to listen on socket '" + socketPath + "': another server is listening on it" );
+      }
+
+      unlink( socketPath.c_str() );
+   }
+
+   if( bind( listener, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) ) != 0 || listen( listener, SOMAXCONN ) != 0 )
+   {
+      close( listener );
+      throw std::runtime_error( "unable to listen on socket '" + socketPath + "': " + std::strerror( errno ) );
+   }
+
+   ServerState state { desc, cache, log, {}, {} };
+   log << "serve: listening on '" << socketPath << "'\n";
+
+   while( true )
+   {
+      int fd = accept( listener, nullptr, nullptr );
+
+      if( fd < 0 )
+      {
+         if( errno == EINTR || errno == ECONNABORTED )
+            continue;
+
+         close( listener );
+         throw std::runtime_error( std::string( "unable to accept connection: " ) + std::strerror( errno ) );
+      }
+
+      std::thread( serve_connection, std::ref( state ), fd ).detach();
+   }
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef _GAMS_SERVER_HPP_
+#define _GAMS_SERVER_HPP_
+
+#include <boost/program_options.hpp>
+#include <ostream>
+#include <string>
+#include "Cache.hpp"
+
+namespace gams {
+
+/**
+ * \brief Serve conversion requests on a local unix socket until the process is terminated.
+ *
+ * A message consists of its length as a 4 byte unsigned integer in network byte order followed
+ * by its contents. A request contains the command line of one conversion like an entry of a
+ * batch manifest, i.e. its input files and options. A client can send several requests over one
+ * connection and several clients are served concurrently.
+ *
+ * The first line of each response is either "ok" followed by the times that were spent
+ * in the request, e.g. "ok parse=0.012 convert=0.034 total=0.046" with times in seconds, or
+ * "error" followed by a message. If the request contains no output file, the gams output
+ * follows the first line of a successful response. Otherwise it is written to the output file.
+ *
+ * The parsed graphs are kept in memory for all following requests with the same control
+ * and model files and are parsed again if one of these files is modified. Requests for the
+ * same graph are converted one after another.
+ *
+ * \param socketPath the path of the socket. An existing file at that path is removed.
+ * \param desc the options that are allowed in the requests
+ * \param cache the cache of conversion results or nullptr
+ * \param log the stream the timing of each request is written to
+ * \throws std::runtime_error if the socket cannot be created
+ */
+void run_server( const std::string& socketPath, const boost::program_options::options_description& desc,
+                 ConversionCache* cache, std::ostream& log );
+
+}
+
+#endif
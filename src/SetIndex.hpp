@@ -1,41 +1,53 @@
 #ifndef _GAMS_SET_INDEX_HPP_
 #define _GAMS_SET_INDEX_HPP_
 
-#include <string>
 #include <limits>
 
 namespace gams {
 
 /**
- * Class representing a set index. the set is given by name and an optional
+ * Sets that are indexed with aliases and offsets, i.e. the time and the stages of the discretization.
+ */
+enum class SetId {
+   T,
+   P
+};
+
+constexpr int SET_COUNT = 2;
+
+/**
+ * Get the name of a set in gams.
+ */
+inline const char* get_set_name( SetId set ) {
+   return set == SetId::T ? "t" : "p";
+}
+
+/**
+ * Class representing a set index. the set is given by its id and an optional
  * offset.
  */
 class SetIndex 
 {
 public:
    /**
-    * Contructor for implicit construction from string literal with offset 0.
+    * Contructor for implicit construction from a set id with offset 0.
     */
-   SetIndex(const char* name) : name(name), offset(0) {}
-   /**
-    * Constructor for construction from string with offset 0
-    */
-   SetIndex(std::string name) : name(std::move(name)), offset(0) {}
-   
+   SetIndex(SetId set) : set(set), offset(0) {}
+
    /**
     * Constructor for set index with an offset
     */
-   SetIndex(std::string name, int offset) : name(std::move(name)), offset(offset) {}
+   SetIndex(SetId set, int offset) : set(set), offset(offset) {}
 
    /**
     * Named "constructor" to get the SetIndex object that represents the first index
-    * for the set with the given name.
+    * for the given set.
     * 
-    * \param name name of set
-    * \return SetIndex object that represents first of set with given name
+    * \param set the set
+    * \return SetIndex object that represents first of the given set
     */
-   static SetIndex First(std::string name) {
-      return SetIndex(std::move(name), FIRST);
+   static SetIndex First(SetId set) {
+      return SetIndex(set, FIRST);
    }
 
    /**
@@ -47,11 +59,11 @@ public:
    }
 
    /**
-    * Get the name of the set
-    * \return const reference to the name
+    * Get the set
+    * \return the id of the set
     */
-   const std::string& getName() const {
-      return name;
+   SetId getSet() const {
+      return set;
    }
 
    /**
@@ -68,9 +80,9 @@ private:
     */
    constexpr static int FIRST = std::numeric_limits<int>::min();
    /**
-    * Name of the set that is indexed
+    * The set that is indexed
     */
-   std::string name;
+   SetId set;
 
    /**
     * Offset for the index
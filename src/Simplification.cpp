@@ -0,0 +1,157 @@
+#include <cmath>
+#include "GamsGenerator.hpp"
+
+namespace gams
+{
+
+bool GamsGenerator::getLiteral( ExpressionGraph::Node* node, bool initial, double& value ) const
+{
+   //negative numbers are negated literals
+   if( node->op == ExpressionGraph::UMINUS && getSymbol( node ).empty() )
+   {
+      if( !getLiteral( node->child1, initial, value ) )
+         return false;
+
+      value = -value;
+      return true;
+   }
+
+   if( node->op != ExpressionGraph::CONSTANT || !getSymbol( node ).empty() )
+      return false;
+
+   //constants that differ between the members of a folded family are parameters
+   if( foldContext_ )
+   {
+      const auto& leaves = foldContext_->leaves[initial && node->type != ExpressionGraph::CONSTANT_NODE];
+
+      if( leaves.find( node ) != leaves.end() )
+         return false;
+   }
+
+   value = node->value;
+   return true;
+}
+
+ExpressionGraph::Node* GamsGenerator::getSimplifiedOperand( ExpressionGraph::Node* node, bool initial ) const
+{
+   if( !simplify_ )
+      return nullptr;
+
+   double value;
+
+   switch( node->op )
+   {
+   case ExpressionGraph::PLUS:
+      if( getLiteral( node->child1, initial, value ) && value == 0. )
+         return node->child2;
+
+      if( getLiteral( node->child2, initial, value ) && value == 0. )
+         return node->child1;
+
+      return nullptr;
+
+   case ExpressionGraph::MINUS:
+      if( getLiteral( node->child2, initial, value ) && value == 0. )
+         return node->child1;
+
+      return nullptr;
+
+   case ExpressionGraph::MULT:
+      if( getLiteral( node->child1, initial, value ) && value == 1. )
+         return node->child2;
+
+      if( getLiteral( node->child2, initial, value ) && value == 1. )
+         return node->child1;
+
+      return nullptr;
+
+   case ExpressionGraph::DIV:
+   case ExpressionGraph::POWER:
+      if( getLiteral( node->child2, initial, value ) && value == 1. )
+         return node->child1;
+
+      return nullptr;
+
+   case ExpressionGraph::UMINUS:
+      //a named negation is translated as its symbol
+      if( node->child1->op == ExpressionGraph::UMINUS && getSymbol( node->child1 ).empty() )
+         return node->child1->child1;
+
+      return nullptr;
+
+   default:
+      return nullptr;
+   }
+}
+
+std::string GamsGenerator::getSimplifiedPattern( ExpressionGraph::Node* node, bool initial ) const
+{
+   if( !simplify_ )
+      return std::string();
+
+   double value;
+
+   switch( node->op )
+   {
+   case ExpressionGraph::MINUS:
+      if( getLiteral( node->child1, initial, value ) && value == 0. )
+         return "-(\2)";
+
+      return std::string();
+
+   case ExpressionGraph::MULT:
+      if( getLiteral( node->child1, initial, value ) && value == -1. )
+         return "-(\2)";
+
+      if( getLiteral( node->child2, initial, value ) && value == -1. )
+         return "-(\1)";
+
+      return std::string();
+
+   case ExpressionGraph::DIV:
+      if( getLiteral( node->child2, initial, value ) && value == -1. )
+         return "-(\1)";
+
+      return std::string();
+
+   case ExpressionGraph::POWER:
+      //x**n is only defined for x > 0 in gams, while power(x, n) is defined for all x
+      if( !getLiteral( node->child2, initial, value ) )
+         return std::string();
+
+      if( value == 0. )
+         return "1";
+
+      if( value == 2. )
+         return "sqr(\1)";
+
+      if( value == 0.5 )
+         return "sqrt(\1)";
+
+      if( value == std::floor( value ) && std::fabs( value ) < 1e9 )
+         return "power(\1, " + std::to_string( static_cast<long long>( value ) ) + ")";
+
+      return std::string();
+
+   case ExpressionGraph::LOG:
+      //the logarithm of a constant base is evaluated once
+      if( !getLiteral( node->child2, initial, value ) || value <= 0. || value == 1. )
+         return std::string();
+
+      if( value == 10. )
+         return "log10(\1)";
+
+      if( value == 2. )
+         return "log2(\1)";
+
+      if( value < 1. )
+         return "log(\1)/(" + format_double( std::log( value ), digits_ ) + ")";
+
+      return "log(\1)/" + format_double( std::log( value ), digits_ );
+
+   default:
+      return std::string();
+   }
+}
+
+}
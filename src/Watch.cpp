@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <sdo/Parsers.hpp>
+#include "Watch.hpp"
+#include "ContentHash.hpp"
+#include "NodeChildren.hpp"
+
+namespace gams
+{
+
+/**
+ * The hashes of the definitions of all symbols of a model and the symbols each definition refers to.
+ */
+struct SymbolHashes {
+   std::map<std::string, std::uint64_t> hashes;
+   std::map<std::string, std::set<std::string>> dependencies;
+};
+
+/**
+ * Hash the structure of a node. Symbols other than the root are hashed by their name, so that
+ * the hash only changes with the definition of the root symbol.
+ */
+static std::uint64_t hash_node( ExpressionGraph& exprGraph, ExpressionGraph::Node* node, bool root,
+                                std::set<std::string>& dependencies )
+{
+   ContentHash hash;
+
+   if( !node )
+   {
+      hash.add( std::string( "nil" ) );
+      return hash.value();
+   }
+
+   auto symbol = exprGraph.getSymbol( node );
+
+   if( !root && !symbol.empty() )
+   {
+      dependencies.insert( symbol.front().second.get() );
+      hash.add( std::string( "symbol" ) );
+      hash.add( symbol.front().second.get() );
+      return hash.value();
+   }
+
+   hash.add( std::uint64_t( node->op ) );
+   hash.add( std::uint64_t( node->type ) );
+
+   switch( node->op )
+   {
+   case ExpressionGraph::CONSTANT:
+      hash.add( node->value );
+      break;
+   case ExpressionGraph::CONTROL:
+      //the bounds and the initial value of a control are no children of the node
+      hash.add( std::uint64_t( node->control_size ) );
+      hash.add( hash_node( exprGraph, node->child1, false, dependencies ) );
+      hash.add( hash_node( exprGraph, node->child2, false, dependencies ) );
+      hash.add( hash_node( exprGraph, node->child3, false, dependencies ) );
+      break;
+   case ExpressionGraph::LOOKUP_TABLE:
+      for( double x : node->lookup_table->getXvals() )
+         hash.add( x );
+
+      for( double y : node->lookup_table->getYvals() )
+         hash.add( y );
+
+      break;
+   case ExpressionGraph::APPLY_LOOKUP:
+      //the table is the first child and not a child the value depends on
+      hash.add( hash_node( exprGraph, node->child1, false, dependencies ) );
+      hash.add( hash_node( exprGraph, node->child2, false, dependencies ) );
+      break;
+   default:
+   {
+      ExpressionGraph::Node* children[3];
+      int n = get_children( node, children );
+
+      for( int i = 0; i < n; ++i )
+         hash.add( hash_node( exprGraph, children[i], false, dependencies ) );
+   }
+   }
+
+   return hash.value();
+}
+
+static SymbolHashes hash_symbols( ExpressionGraph& exprGraph )
+{
+   SymbolHashes result;
+
+   for( auto& entry : exprGraph.getSymbolTable() )
+   {
+      std::string name = entry.first.get();
+      ContentHash hash;
+      hash.add( hash_node( exprGraph, entry.second, true, result.dependencies[name] ) );
+
+      //the comments are part of the output
+      for( auto& comment : exprGraph.getComments( entry.first ) )
+         hash.add( comment.second );
+
+      result.hashes[name] = hash.value();
+   }
+
+   return result;
+}
+
+/**
+ * Hash the inputs that are not part of the graph, i.e. the objective and the scenarios.
+ */
+static std::uint64_t hash_other_inputs( const ConversionInputs& inputs, const ConversionOptions& options )
+{
+   ContentHash hash;
+   std::vector<std::string> files = inputs.vpdFiles;
+
+   if( !options.scenarioFile.empty() )
+      files.push_back( options.scenarioFile );
+
+   for( const std::string& file : files )
+   {
+      std::ifstream in( file, std::ios::binary );
+      std::string contents( ( std::istreambuf_iterator<char>( in ) ), std::istreambuf_iterator<char>() );
+      hash.add( contents );
+   }
+
+   return hash.value();
+}
+
+/**
+ * Rewrite the part of the file that differs from the given contents.
+ *
+ * \return the offset of the first byte that was written or the size of the contents if the file
+ *         did not change
+ */
+static std::size_t patch_file( const std::string& name, const std::string& contents )
+{
+   std::string old;
+   {
+      std::ifstream in( name, std::ios::binary );
+      old.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+   }
+
+   std::size_t offset = std::mismatch( contents.begin(), contents.begin() + std::min( contents.size(), old.size() ), old.begin() ).first - contents.begin();
+
+   if( offset == contents.size() && old.size() == contents.size() )
+      return offset;
+
+   //the file is patched in place, so that it keeps its identity for editors that have it open
+   std::fstream file( name, old.empty() ? std::ios::out | std::ios::binary : std::ios::in | std::ios::out | std::ios::binary );
+   file.seekp( offset );
+   file.write( contents.data() + offset, contents.size() - offset );
+   file.close();
+
+   if( file.fail() || ( old.size() > contents.size() && truncate( name.c_str(), contents.size() ) != 0 ) )
+      throw std::runtime_error( "unable to write to file '" + name + "'" );
+
+   return offset;
+}
+
+/**
+ * Get the symbols whose definitions differ and the symbols that depend on them.
+ */
+static void get_changes( const SymbolHashes& previous, const SymbolHashes& current,
+                         std::set<std::string>& changed, std::set<std::string>& affected )
+{
+   for( auto& entry : current.hashes )
+   {
+      auto old = previous.hashes.find( entry.first );
+
+      if( old == previous.hashes.end() || old->second != entry.second )
+         changed.insert( entry.first );
+   }
+
+   for( auto& entry : previous.hashes )
+   {
+      if( !current.hashes.count( entry.first ) )
+         changed.insert( entry.first );
+   }
+
+   //propagate the changes to the symbols depending on them until nothing is added
+   affected = changed;
+   bool added = true;
+
+   while( added )
+   {
+      added = false;
+
+      for( auto& entry : current.dependencies )
+      {
+         if( affected.count( entry.first ) )
+            continue;
+
+         for( const std::string& dependency : entry.second )
+         {
+            if( affected.count( dependency ) )
+            {
+               affected.insert( entry.first );
+               added = true;
+               break;
+            }
+         }
+      }
+   }
+}
+
+static std::string list_symbols( const std::set<std::string>& symbols )
+{
+   const std::size_t max = 10;
+   std::string list;
+   std::size_t n = 0;
+
+   for( const std::string& symbol : symbols )
+   {
+      if( n++ == max )
+         return list + ", ...";
+
+      list += ( list.empty() ? "'" : ", '" ) + symbol + "'";
+   }
+
+   return list;
+}
+
+void run_watch( const ConversionInputs& inputs, const ConversionOptions& options,
+                const std::string& outputFile, std::ostream& log )
+{
+   typedef std::chrono::steady_clock Clock;
+   int fd = inotify_init();
+
+   if( fd < 0 )
+      throw std::runtime_error( "unable to monitor the input files" );
+
+   //the directories are watched, since editors often replace a file instead of writing it
+   std::map<int, std::set<std::string>> watched;
+   std::vector<std::string> files = inputs.mdlFiles;
+   files.insert( files.end(), inputs.vocFiles.begin(), inputs.vocFiles.end() );
+   files.insert( files.end(), inputs.vpdFiles.begin(), inputs.vpdFiles.end() );
+
+   if( !options.scenarioFile.empty() )
+      files.push_back( options.scenarioFile );
+
+   for( const std::string& file : files )
+   {
+      std::size_t slash = file.find_last_of( '/' );
+      std::string directory = slash == std::string::npos ? "." : file.substr( 0, slash + 1 );
+      int wd = inotify_add_watch( fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE );
+
+      if( wd < 0 )
+      {
+         close( fd );
+         throw std::runtime_error( "unable to monitor directory '" + directory + "'" );
+      }
+
+      watched[wd].insert( slash == std::string::npos ? file : file.substr( slash + 1 ) );
+   }
+
+   SymbolHashes previous;
+   std::uint64_t previousOther = 0;
+   bool converted = false;
+
+   while( true )
+   {
+      Clock::time_point start = Clock::now();
+
+      try
+      {
+         sdo::ExpressionGraph exprGraph;
+         parse_model( inputs, exprGraph );
+
+         //the hashes are computed before the conversion adds symbols to the graph
+         SymbolHashes current = hash_symbols( exprGraph );
+         std::uint64_t other = hash_other_inputs( inputs, options );
+         std::set<std::string> changed, affected;
+         get_changes( previous, current, changed, affected );
+
+         if( converted && changed.empty() && other == previousOther )
+         {
+            log << "watch: no symbol changed\n";
+         }
+         else
+         {
+            std::ostringstream gams;
+            convert( exprGraph, inputs, options, gams, outputFile );
+            std::string result = gams.str();
+            std::size_t offset = patch_file( outputFile, result );
+            double seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+
+            if( converted )
+               log << "watch: " << changed.size() << " changed symbols " << list_symbols( changed ) << " affect "
+                   << affected.size() << " symbols\n";
+
+            log << "watch: converted in " << seconds << " s, rewrote " << result.size() - offset
+                << " of " << result.size() << " bytes of '" << outputFile << "'\n";
+         }
+
+         previous = std::move( current );
+         previousOther = other;
+         converted = true;
+      }
+      catch( const sdo::parse_error& err )
+      {
+         log << err.what();
+      }
+      catch( const std::ifstream::failure& err )
+      {
+         log << "Error: cannot read file\n";
+      }
+      catch( const std::runtime_error& err )
+      {
+         log << "Error: " << err.what() << "\n";
+      }
+
+      log << "watch: waiting for changes\n";
+
+      //wait for a change of an input file and for the end of the following burst of events
+      bool change = false;
+      int timeout = -1;
+      alignas( inotify_event ) char buffer[4096];
+
+      while( true )
+      {
+         pollfd pfd { fd, POLLIN, 0 };
+         int ready = poll( &pfd, 1, timeout );
+
+         if( ready < 0 && errno != EINTR )
+         {
+            close( fd );
+            throw std::runtime_error( "unable to monitor the input files" );
+         }
+
+         if( ready == 0 )
+            break;
+
+         if( ready < 0 )
+            continue;
+
+         ssize_t length = read( fd, buffer, sizeof( buffer ) );
+
+         for( char* pos = buffer; pos < buffer + length; )
+         {
+            inotify_event* event = reinterpret_cast<inotify_event*>( pos );
+
+            if( event->len > 0 && watched[event->wd].count( event->name ) )
+               change = true;
+
+            pos += sizeof( inotify_event ) + event->len;
+         }
+
+         if( change )
+            timeout = 100;
+      }
+   }
+}
+
+}
@@ -0,0 +1,31 @@
+#ifndef _GAMS_WATCH_HPP_
+#define _GAMS_WATCH_HPP_
+
+#include <ostream>
+#include <string>
+#include "Conversion.hpp"
+
+namespace gams {
+
+/**
+ * \brief Convert a model and convert it again whenever one of its input files changes.
+ *
+ * The input files are monitored with inotify. After a change the model is parsed again and
+ * the definition of every symbol is hashed. If no definition, comment or other input changed,
+ * the output is left as it is. Otherwise the model is converted and only the part of the output
+ * file that differs from the previous output is rewritten. The changed symbols and the symbols
+ * depending on them are written to the log. This function does not return unless an error
+ * occurs while monitoring the files.
+ *
+ * \param inputs the input files
+ * \param options the options of the conversion, which must not use the interactive lookup-type
+ * \param outputFile the name of the output file
+ * \param log the stream the changes and the errors of the conversions are written to
+ * \throws std::runtime_error if the input files cannot be monitored
+ */
+void run_watch( const ConversionInputs& inputs, const ConversionOptions& options,
+                const std::string& outputFile, std::ostream& log );
+
+}
+
+#endif
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stack>
+#include <unordered_set>
+#include <boost/program_options.hpp>
+#include <sdo/Parsers.hpp>
+#include "ModelGenerator.hpp"
+#include "../Conversion.hpp"
+#include "../NodeChildren.hpp"
+#include "../Profile.hpp"
+
+using namespace gams;
+
+/**
+ * Time and size of one conversion.
+ */
+struct Measurement {
+   double parseSeconds = 0.;
+   double convertSeconds = 0.;
+   std::size_t nodes = 0; //< number of nodes of the parsed graph
+   std::size_t bytes = 0; //< size of the gams output
+   Profile profile;
+};
+
+static std::size_t count_nodes( ExpressionGraph& exprGraph )
+{
+   std::unordered_set<ExpressionGraph::Node*> visited;
+   std::stack<ExpressionGraph::Node*> stack;
+
+   for( auto& entry : exprGraph.getSymbolTable() )
+      stack.push( entry.second );
+
+   while( !stack.empty() )
+   {
+      ExpressionGraph::Node* top = stack.top();
+      stack.pop();
+
+      if( !visited.insert( top ).second )
+         continue;
+
+      ExpressionGraph::Node* children[3];
+      int n = get_children( top, children );
+
+      for( int i = 0; i < n; ++i )
+         stack.push( children[i] );
+   }
+
+   return visited.size();
+}
+
+/**
+ * Convert a synthetic model several times and return the run with the median total time.
+ * With analyses set the optional analyses of the graph run as well.
+ */
+static Measurement measure( const ModelParameters& parameters, sdo::ButcherTableau::Name method,
+                            const std::string& directory, int repetitions, bool analyses )
+{
+   ConversionInputs inputs;
+   inputs.mdlFiles.push_back( directory + "/bench.mdl" );
+   inputs.vocFiles.push_back( directory + "/bench.voc" );
+   {
+      std::ofstream mdl( inputs.mdlFiles.front() );
+      std::ofstream voc( inputs.vocFiles.front() );
+      write_model( parameters, mdl, voc );
+   }
+
+   ConversionOptions options;
+   options.discretization = method;
+   options.lookupType = "sos2";
+
+   if( analyses )
+   {
+      options.deadSymbols = DeadSymbolHandling::DROP;
+      options.scaling = true;
+      options.blockOrdering = true;
+      options.foldEquations = true;
+   }
+
+   std::vector<Measurement> runs( repetitions );
+
+   for( Measurement& run : runs )
+   {
+      sdo::ExpressionGraph exprGraph;
+      parse_model( inputs, exprGraph, &run.profile );
+      run.nodes = count_nodes( exprGraph );
+
+      std::ostringstream out;
+      convert( exprGraph, inputs, options, out, std::string(), &run.profile );
+      run.bytes = out.str().size();
+
+      for( const Profile::PhaseData& phase : run.profile.getPhases() )
+      {
+         if( phase.name == "parse" || phase.name == "analyze" )
+            run.parseSeconds += phase.wallSeconds;
+         else
+            run.convertSeconds += phase.wallSeconds;
+      }
+   }
+
+   std::sort( runs.begin(), runs.end(), []( const Measurement& a, const Measurement& b )
+   {
+      return a.parseSeconds + a.convertSeconds < b.parseSeconds + b.convertSeconds;
+   } );
+
+   return std::move( runs[runs.size() / 2] );
+}
+
+static void print_header()
+{
+   std::cout << std::left << std::setw( 12 ) << "  value" << std::right
+             << std::setw( 10 ) << "nodes" << std::setw( 12 ) << "bytes"
+             << std::setw( 12 ) << "parse [s]" << std::setw( 12 ) << "convert [s]"
+             << std::setw( 14 ) << "nodes/s" << std::setw( 14 ) << "MB/s" << "\n";
+}
+
+static void print_row( const std::string& label, const Measurement& m )
+{
+   double seconds = m.parseSeconds + m.convertSeconds;
+   std::cout << std::left << std::setw( 12 ) << "  " + label << std::right
+             << std::setw( 10 ) << m.nodes << std::setw( 12 ) << m.bytes
+             << std::setw( 12 ) << m.parseSeconds << std::setw( 12 ) << m.convertSeconds
+             << std::setw( 14 ) << m.nodes / seconds << std::setw( 14 ) << m.bytes / seconds / 1e6 << "\n";
+}
+
+int main( int argc, char const* argv[] )
+{
+   namespace po = boost::program_options;
+   ModelParameters parameters;
+   int repetitions;
+   std::string directory;
+   bool analyses;
+
+   po::options_description desc( "Allowed options" );
+   desc.add_options()
+   ( "help,h", "produce help message" )
+   ( "stocks", po::value<int>( &parameters.stocks )->default_value( 200 ), "Number of stocks of the base model, each with an auxiliary as rate." )
+   ( "fan-in", po::value<int>( &parameters.fanIn )->default_value( 3 ), "Number of symbols each auxiliary refers to." )
+   ( "sharing", po::value<double>( &parameters.sharing )->default_value( 0.5 ), "Probability that an auxiliary refers to an earlier auxiliary." )
+   ( "lookups", po::value<int>( &parameters.lookups )->default_value( 4 ), "Number of lookup tables." )
+   ( "lookup-size", po::value<int>( &parameters.lookupSize )->default_value( 10 ), "Number of points of each lookup table." )
+   ( "delays", po::value<int>( &parameters.delays )->default_value( 4 ), "Number of fixed delays." )
+   ( "controls", po::value<int>( &parameters.controls )->default_value( 2 ), "Number of controls." )
+   ( "control-steps", po::value<int>( &parameters.controlSteps )->default_value( 1 ), "Number of time steps in which a control is constant." )
+   ( "horizon", po::value<int>( &parameters.horizon )->default_value( 100 ), "Number of time steps." )
+   ( "repetitions,r", po::value<int>( &repetitions )->default_value( 5 ), "Number of runs of each measurement, of which the median is reported." )
+   ( "directory", po::value<std::string>( &directory )->default_value( "." ), "Directory the synthetic models are written to." )
+   ( "analyses", po::bool_switch( &analyses ), "Drop dead symbols, order the blocks, scale and fold the equations in each conversion, so that these phases are measured." )
+   ;
+
+   po::variables_map vm;
+
+   try
+   {
+      po::store( po::parse_command_line( argc, argv, desc ), vm );
+      po::notify( vm );
+   }
+   catch( po::error& e )
+   {
+      std::cerr << "Error: " << e.what() << "\n";
+      exit( 0 );
+   }
+
+   if( vm.count( "help" ) )
+   {
+      std::cout << desc;
+      exit( 0 );
+   }
+
+   repetitions = std::max( 1, repetitions );
+
+   try
+   {
+      std::cout << std::setprecision( 4 );
+
+      Measurement base = measure( parameters, sdo::ButcherTableau::RUNGE_KUTTA_2, directory, repetitions, analyses );
+      std::cout << "phases of the base model with rk2 (" << base.nodes << " nodes)\n"
+                << std::left << std::setw( 28 ) << "  phase" << std::right << std::setw( 12 ) << "wall [s]"
+                << std::setw( 12 ) << "cpu [s]" << std::setw( 12 ) << "allocs" << std::setw( 12 ) << "visits"
+                << std::setw( 14 ) << "visits/s" << "\n";
+
+      for( const Profile::PhaseData& phase : base.profile.getPhases() )
+      {
+         std::cout << std::left << std::setw( 28 ) << "  " + phase.name << std::right
+                   << std::setw( 12 ) << phase.wallSeconds << std::setw( 12 ) << phase.cpuSeconds
+                   << std::setw( 12 ) << phase.allocations << std::setw( 12 ) << phase.nodesVisited
+                   << std::setw( 14 ) << ( phase.wallSeconds > 0. ? phase.nodesVisited / phase.wallSeconds : 0. ) << "\n";
+      }
+
+      std::cout << "\ndiscretization methods\n";
+      print_header();
+      const std::pair<const char*, sdo::ButcherTableau::Name> methods[] = {
+         { "euler", sdo::ButcherTableau::EULER }, { "rk2", sdo::ButcherTableau::RUNGE_KUTTA_2 },
+         { "rk3", sdo::ButcherTableau::RUNGE_KUTTA_3 }, { "rk4", sdo::ButcherTableau::RUNGE_KUTTA_4 },
+         { "imid2", sdo::ButcherTableau::IMPLICIT_MIDPOINT_2 }, { "igl4", sdo::ButcherTableau::GAUSS_LEGENDRE_4 }
+      };
+
+      for( auto& method : methods )
+         print_row( method.first, measure( parameters, method.second, directory, repetitions, analyses ) );
+
+      std::cout << "\nscaling with the number of stocks\n";
+      print_header();
+
+      for( int factor : { 1, 2, 4, 8, 16 } )
+      {
+         ModelParameters scaled = parameters;
+         scaled.stocks = std::max( 1, parameters.stocks * factor / 4 );
+         print_row( std::to_string( scaled.stocks ), measure( scaled, sdo::ButcherTableau::RUNGE_KUTTA_2, directory, repetitions, analyses ) );
+      }
+
+      std::cout << "\nscaling with the horizon\n";
+      print_header();
+
+      for( int factor : { 1, 10, 100 } )
+      {
+         ModelParameters scaled = parameters;
+         scaled.horizon = std::max( 1, parameters.horizon * factor / 10 );
+         print_row( std::to_string( scaled.horizon ), measure( scaled, sdo::ButcherTableau::RUNGE_KUTTA_2, directory, repetitions, analyses ) );
+      }
+   }
+   catch( const sdo::parse_error& err )
+   {
+      std::cerr << err.what();
+   }
+   catch( const std::runtime_error& err )
+   {
+      std::cerr << "Error: " << err.what() << "\n";
+   }
+
+   return 0;
+}
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <boost/program_options.hpp>
+#include <sdo/Parsers.hpp>
+#include "ModelGenerator.hpp"
+#include "../Conversion.hpp"
+#include "../Escape.hpp"
+
+using namespace gams;
+
+/**
+ * The escaping before the transliteration table, which replaces the seven German characters
+ * with one scan of the string each.
+ */
+static std::string escape_string_reference( std::string str )
+{
+   auto replace = [&str]( const std::string& search, const std::string& replacement )
+   {
+      for( std::size_t pos = 0; ( pos = str.find( search, pos ) ) != std::string::npos; pos += replacement.size() )
+         str.replace( pos, search.size(), replacement );
+   };
+
+   str.erase( std::remove_if( str.begin(), str.end(), []( char c ) { return c == ' ' || c == '-'; } ), str.end() );
+   replace( "Ä", "AE" );
+   replace( "Ö", "OE" );
+   replace( "Ü", "UE" );
+   replace( "ä", "ae" );
+   replace( "ö", "oe" );
+   replace( "ü", "ue" );
+   replace( "ß", "ss" );
+
+   auto isVocale = []( char c ) { return c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u'; };
+
+   if( str.size() > 59 )
+      str.erase( std::remove_if( str.begin(), str.end(), isVocale ), str.end() );
+
+   if( str.size() > 59 )
+      str.erase( str.begin() + 59, str.end() );
+
+   return str;
+}
+
+/**
+ * Receives the sizes of the escaped names, so that the escaping can not be optimized away.
+ */
+static volatile std::size_t checksum_sink;
+
+/**
+ * Get the median time in nanoseconds per name of escaping all names with the given function.
+ */
+template<typename Escape>
+static double measure( const std::vector<std::string>& names, int repetitions, Escape escape )
+{
+   std::vector<double> times;
+   std::size_t checksum = 0;
+
+   for( int i = 0; i < repetitions; ++i )
+   {
+      auto start = std::chrono::steady_clock::now();
+
+      for( const std::string& name : names )
+         checksum += escape( name ).size();
+
+      std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+      times.push_back( time.count() / names.size() );
+   }
+
+   //keep the results alive
+   checksum_sink = checksum;
+
+   std::sort( times.begin(), times.end() );
+   return times[times.size() / 2];
+}
+
+/**
+ * Names in the style of German and other European models for the synthetic corpus.
+ */
+static std::vector<std::string> get_synthetic_names( int count )
+{
+   const char* words[] = {
+      "Bevölkerung", "Größe", "Zuwachsrate", "Übergang", "Änderung", "stock", "flow", "rate",
+      "café", "crème", "Łódź", "niño", "Œuvre", "year-end", "initial level", "production capacity"
+   };
+   const std::size_t nWords = sizeof( words ) / sizeof( words[0] );
+
+   std::vector<std::string> names;
+   std::stringstream mdl;
+   std::stringstream voc;
+   ModelParameters parameters;
+   parameters.stocks = count / 2;
+   write_model( parameters, mdl, voc );
+
+   //half of the names are the plain names of a synthetic model
+   for( std::string line; std::getline( mdl, line ) && names.size() < std::size_t( count / 2 ); )
+   {
+      std::size_t end = line.find( " = " );
+
+      if( end != std::string::npos )
+         names.push_back( line.substr( 0, end ) );
+   }
+
+   for( std::size_t i = 0; names.size() < std::size_t( count ); ++i )
+      names.push_back( std::string( words[i % nWords] ) + " " + words[( i / nWords ) % nWords] + " " + std::to_string( i ) );
+
+   return names;
+}
+
+int main( int argc, char const* argv[] )
+{
+   namespace po = boost::program_options;
+   int repetitions;
+   int count;
+
+   po::options_description desc( "Allowed options" );
+   desc.add_options()
+   ( "help,h", "produce help message" )
+   ( "input-files", po::value< std::vector<std::string> >(), "Model files whose symbols are the corpus. Without files a synthetic corpus is used." )
+   ( "names", po::value<int>( &count )->default_value( 20000 ), "Number of names of the synthetic corpus." )
+   ( "repetitions,r", po::value<int>( &repetitions )->default_value( 21 ), "Number of runs of each measurement, of which the median is reported." )
+   ;
+   po::positional_options_description p;
+   p.add( "input-files", -1 );
+   po::variables_map vm;
+
+   try
+   {
+      po::store( po::command_line_parser( argc, argv ).options( desc ).positional( p ).run(), vm );
+      po::notify( vm );
+   }
+   catch( po::error& e )
+   {
+      std::cerr << "Error: " << e.what() << "\n";
+      exit( 0 );
+   }
+
+   if( vm.count( "help" ) )
+   {
+      std::cout << desc;
+      exit( 0 );
+   }
+
+   std::vector<std::string> names;
+
+   try
+   {
+      if( vm.count( "input-files" ) )
+      {
+         sdo::ExpressionGraph exprGraph;
+         parse_model( get_conversion_inputs( vm["input-files"].as< std::vector<std::string> >() ), exprGraph );
+
+         for( auto& entry : exprGraph.getSymbolTable() )
+            names.push_back( entry.first.get() );
+      }
+      else
+      {
+         names = get_synthetic_names( std::max( 2, count ) );
+      }
+   }
+   catch( const sdo::parse_error& err )
+   {
+      std::cerr << err.what();
+      exit( 0 );
+   }
+   catch( const std::runtime_error& err )
+   {
+      std::cerr << "Error: " << err.what() << "\n";
+      exit( 0 );
+   }
+
+   if( names.empty() )
+   {
+      std::cerr << "Error: the corpus has no names\n";
+      exit( 0 );
+   }
+
+   std::size_t bytes = 0;
+   std::size_t differing = 0;
+
+   for( const std::string& name : names )
+   {
+      bytes += name.size();
+      differing += escape_string( name ) != escape_string_reference( name );
+   }
+
+   repetitions = std::max( 1, repetitions );
+   double reference = measure( names, repetitions, escape_string_reference );
+   double table = measure( names, repetitions, []( const std::string& name ) { return escape_string( name ); } );
+
+   std::cout << std::setprecision( 4 )
+             << names.size() << " names, " << bytes << " bytes, " << differing << " escaped differently\n"
+             << std::left << std::setw( 16 ) << "  method" << std::right << std::setw( 12 ) << "ns/name" << std::setw( 12 ) << "MB/s" << "\n"
+             << std::left << std::setw( 16 ) << "  reference" << std::right << std::setw( 12 ) << reference
+             << std::setw( 12 ) << bytes / ( reference * names.size() ) * 1e3 << "\n"
+             << std::left << std::setw( 16 ) << "  table" << std::right << std::setw( 12 ) << table
+             << std::setw( 12 ) << bytes / ( table * names.size() ) * 1e3 << "\n";
+
+   return 0;
+}
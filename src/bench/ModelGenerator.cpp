@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "ModelGenerator.hpp"
+
+namespace gams
+{
+
+static void equation( std::ostream& mdl, const std::string& name, const std::string& definition )
+{
+   mdl << name << " = " << definition << "\n\t~\t~\t|\n";
+}
+
+void write_model( const ModelParameters& parameters, std::ostream& mdl, std::ostream& voc )
+{
+   std::mt19937 random( parameters.seed );
+   std::uniform_real_distribution<double> value( 0.1, 2. );
+   std::uniform_real_distribution<double> probability( 0., 1. );
+   auto pick = [&random]( std::size_t size )
+   {
+      return std::uniform_int_distribution<std::size_t>( 0, size - 1 )( random );
+   };
+
+   //the symbols that auxiliaries refer to besides other auxiliaries
+   std::vector<std::string> leaves;
+   std::vector<std::string> stocks;
+   mdl << "{UTF-8}\n";
+
+   for( int i = 0; i < parameters.stocks; ++i )
+      stocks.push_back( "stock " + std::to_string( i ) );
+
+   leaves = stocks;
+
+   for( int i = 0; i < std::max( 1, parameters.stocks / 4 ); ++i )
+   {
+      std::string name = "constant " + std::to_string( i );
+      equation( mdl, name, std::to_string( value( random ) ) );
+      leaves.push_back( name );
+   }
+
+   for( int i = 0; i < parameters.controls; ++i )
+   {
+      std::string name = "control " + std::to_string( i );
+      voc << "0<=" << name << "=0.5<=1";
+
+      if( parameters.controlSteps > 1 )
+         voc << ":" << parameters.controlSteps;
+
+      voc << "\n";
+      leaves.push_back( name );
+   }
+
+   for( int i = 0; i < parameters.lookups; ++i )
+   {
+      std::string table = "table " + std::to_string( i );
+      std::string points;
+
+      for( int j = 0; j < parameters.lookupSize; ++j )
+         points += ( j == 0 ? "(" : ",(" ) + std::to_string( j ) + "," + std::to_string( value( random ) ) + ")";
+
+      mdl << table << "(" << points << ")\n\t~\t~\t|\n";
+
+      std::string name = "lookup use " + std::to_string( i );
+      equation( mdl, name, table + "(" + stocks[pick( stocks.size() )] + " / " + std::to_string( parameters.lookupSize ) + ")" );
+      leaves.push_back( name );
+   }
+
+   for( int i = 0; i < parameters.delays; ++i )
+   {
+      std::string name = "delayed " + std::to_string( i );
+      equation( mdl, name, "DELAY FIXED(" + stocks[pick( stocks.size() )] + ", 1, 0)" );
+      leaves.push_back( name );
+   }
+
+   //the auxiliaries only refer to earlier auxiliaries, so they form a DAG
+   for( int i = 0; i < parameters.stocks; ++i )
+   {
+      std::string definition;
+
+      for( int j = 0; j < parameters.fanIn; ++j )
+      {
+         std::string term;
+
+         if( i > 0 && probability( random ) < parameters.sharing )
+            term = "aux " + std::to_string( pick( i ) );
+         else
+            term = leaves[pick( leaves.size() )];
+
+         if( j > 0 )
+            definition += j % 2 == 0 ? " + " : " * ";
+
+         definition += term;
+      }
+
+      equation( mdl, "aux " + std::to_string( i ), "0.01 * (" + definition + ")" );
+   }
+
+   for( int i = 0; i < parameters.stocks; ++i )
+   {
+      equation( mdl, stocks[i], "INTEG(aux " + std::to_string( i ) + " - 0.1 * " + stocks[i] + ", " + std::to_string( value( random ) ) + ")" );
+   }
+
+   equation( mdl, "FINAL TIME", std::to_string( parameters.horizon ) );
+   equation( mdl, "INITIAL TIME", "0" );
+   equation( mdl, "TIME STEP", "1" );
+}
+
+}
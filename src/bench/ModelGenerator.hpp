@@ -0,0 +1,40 @@
+#ifndef _GAMS_BENCH_MODEL_GENERATOR_HPP_
+#define _GAMS_BENCH_MODEL_GENERATOR_HPP_
+
+#include <ostream>
+
+namespace gams {
+
+/**
+ * \brief Shape of a synthetic model.
+ */
+struct ModelParameters {
+   int stocks = 100;
+   int fanIn = 3; //< number of symbols each auxiliary refers to
+   double sharing = 0.5; //< probability that a reference goes to an earlier auxiliary instead of a stock
+   int lookups = 4;
+   int lookupSize = 10; //< number of points of each lookup table
+   int delays = 4; //< number of auxiliaries that are delayed
+   int controls = 2;
+   int controlSteps = 1; //< number of time steps in which each control is constant
+   int horizon = 100; //< number of time steps
+   unsigned seed = 1;
+};
+
+/**
+ * \brief Write a random model with the given shape as model and control files.
+ *
+ * Each stock has an auxiliary as its rate. The auxiliaries are sums and products of
+ * earlier auxiliaries, stocks, controls and constants, so that the symbols form a DAG whose
+ * sharing grows with ModelParameters::sharing. Some auxiliaries apply lookups or fixed delays.
+ * The same parameters always yield the same model.
+ *
+ * \param parameters the shape of the model
+ * \param mdl the stream the model file is written to
+ * \param voc the stream the control file is written to
+ */
+void write_model( const ModelParameters& parameters, std::ostream& mdl, std::ostream& voc );
+
+}
+
+#endif
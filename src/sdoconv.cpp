@@ -0,0 +1,109 @@
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <sdo/Parsers.hpp>
+#include "Conversion.hpp"
+#include "sdoconv.h"
+
+namespace
+{
+
+/**
+ * Stream buffer that passes its contents to a sink whenever it is full or flushed.
+ */
+class SinkBuffer : public std::streambuf {
+public:
+   SinkBuffer( sdoconv_sink sink, void* userData ) : sink_( sink ), userData_( userData )
+   {
+      setp( buffer_, buffer_ + sizeof( buffer_ ) );
+   }
+
+protected:
+   int_type overflow( int_type c ) override
+   {
+      flush();
+
+      if( !traits_type::eq_int_type( c, traits_type::eof() ) )
+      {
+         *pptr() = traits_type::to_char_type( c );
+         pbump( 1 );
+      }
+
+      return traits_type::not_eof( c );
+   }
+
+   int sync() override
+   {
+      flush();
+      return 0;
+   }
+
+private:
+   void flush()
+   {
+      if( pptr() != pbase() )
+         sink_( pbase(), pptr() - pbase(), userData_ );
+
+      setp( buffer_, buffer_ + sizeof( buffer_ ) );
+   }
+
+   sdoconv_sink sink_;
+   void* userData_;
+   char buffer_[1 << 16];
+};
+
+void set_error( char* error, std::size_t errorSize, const char* message )
+{
+   if( !error || errorSize == 0 )
+      return;
+
+   std::strncpy( error, message, errorSize - 1 );
+   error[errorSize - 1] = '\0';
+}
+
+}
+
+extern "C" int sdoconv_convert( const sdoconv_buffer* mdl, size_t numMdl, const sdoconv_buffer* voc, size_t numVoc,
+                                const sdoconv_buffer* vpd, const char* const* options, size_t numOptions,
+                                sdoconv_sink sink, void* userData, char* error, size_t errorSize )
+{
+   namespace po = boost::program_options;
+
+   try
+   {
+      gams::ConversionBuffers buffers;
+
+      for( std::size_t i = 0; i < numMdl; ++i )
+         buffers.mdlContents.emplace_back( mdl[i].data, mdl[i].size );
+
+      for( std::size_t i = 0; i < numVoc; ++i )
+         buffers.vocContents.emplace_back( voc[i].data, voc[i].size );
+
+      if( vpd )
+         buffers.vpdContents.assign( vpd->data, vpd->size );
+
+      po::options_description desc;
+      gams::add_conversion_options( desc );
+      po::variables_map vm;
+      po::store( po::command_line_parser( std::vector<std::string>( options, options + numOptions ) ).options( desc ).run(), vm );
+      po::notify( vm );
+
+      SinkBuffer buffer( sink, userData );
+      std::ostream out( &buffer );
+      gams::convert_buffers( buffers, gams::get_conversion_options( vm ), out );
+      out.flush();
+   }
+   catch( const std::exception& err )
+   {
+      set_error( error, errorSize, err.what() );
+      return 1;
+   }
+   //no exception may leave the c interface
+   catch( ... )
+   {
+      set_error( error, errorSize, "unknown error" );
+      return 1;
+   }
+
+   return 0;
+}
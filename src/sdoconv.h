@@ -0,0 +1,51 @@
+#ifndef _SDOCONV_H_
+#define _SDOCONV_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Contents of an input file held in memory.
+ */
+typedef struct sdoconv_buffer {
+   const char* data;
+   size_t size;
+} sdoconv_buffer;
+
+/**
+ * \brief Receives the gams output in pieces of the given size.
+ */
+typedef void ( *sdoconv_sink )( const char* data, size_t size, void* userData );
+
+/**
+ * \brief Convert a model given by the contents of its files to gams.
+ *
+ * The options are given like on the command line of sdoconv, e.g. "--discretization-method=rk4" or
+ * "-l" followed by "sos2". An interactive lookup-type is an error.
+ *
+ * \param mdl the contents of the model files
+ * \param numMdl the number of model files
+ * \param voc the contents of the control files
+ * \param numVoc the number of control files
+ * \param vpd the contents of the objective file or NULL
+ * \param options the options of the conversion
+ * \param numOptions the number of options
+ * \param sink the function receiving the gams output
+ * \param userData passed to the sink
+ * \param error buffer receiving a null-terminated message if the conversion fails, or NULL
+ * \param errorSize the size of the error buffer
+ * \return 0 if the conversion succeeded and nonzero otherwise. If the conversion fails the sink
+ *         may already have received part of the output, which must be discarded.
+ */
+int sdoconv_convert( const sdoconv_buffer* mdl, size_t numMdl, const sdoconv_buffer* voc, size_t numVoc,
+                     const sdoconv_buffer* vpd, const char* const* options, size_t numOptions,
+                     sdoconv_sink sink, void* userData, char* error, size_t errorSize );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
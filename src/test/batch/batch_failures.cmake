@@ -0,0 +1,34 @@
+# runs a batch whose second model fails to parse and checks that each of its entries is
+# reported and that the exit status shows the failures, called with -DSDOCONV=<binary>
+# -DMODELS=<dir> -DWORK=<dir>
+
+set(MODEL ${MODELS}/batch/division.mdl ${MODELS}/batch/division.voc ${MODELS}/batch/division.vpd -l sos2)
+set(BROKEN ${WORK}/broken.mdl ${MODELS}/batch/division.voc -l sos2)
+
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK})
+file(WRITE ${WORK}/broken.mdl "{UTF-8}\nstock = 1 + * 2\n\t~\t~\t|\n")
+
+set(MANIFEST "")
+foreach(ENTRY "${MODEL};-o;${WORK}/good.gms" "${BROKEN};-o;${WORK}/broken1.gms"
+		"${BROKEN};--quotients;-o;${WORK}/broken2.gms" "${BROKEN};-d;rk4;-o;${WORK}/broken3.gms")
+	string(REPLACE ";" " " LINE "${ENTRY}")
+	string(APPEND MANIFEST "${LINE}\n")
+endforeach()
+file(WRITE ${WORK}/manifest.txt "${MANIFEST}")
+
+execute_process(COMMAND ${SDOCONV} --batch ${WORK}/manifest.txt -j 1 RESULT_VARIABLE RESULT ERROR_VARIABLE LOG)
+
+if(RESULT EQUAL 0)
+	message(FATAL_ERROR "batch with failed entries exited with status 0:\n${LOG}")
+endif()
+
+foreach(LINE 3 4)
+	if(NOT LOG MATCHES "manifest\\.txt:${LINE}: skipped: model failed to parse")
+		message(FATAL_ERROR "entry ${LINE} of the broken model was not reported:\n${LOG}")
+	endif()
+endforeach()
+
+if(NOT LOG MATCHES "converted 1 of 4 entries" OR NOT EXISTS ${WORK}/good.gms)
+	message(FATAL_ERROR "the good entry was not converted:\n${LOG}")
+endif()
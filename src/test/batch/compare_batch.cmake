@@ -0,0 +1,36 @@
+# converts the same model with and without quotients in one batch and compares the results
+# with the conversions of single runs, called with -DSDOCONV=<binary> -DMODELS=<dir> -DWORK=<dir>
+
+set(MODEL ${MODELS}/batch/division.mdl ${MODELS}/batch/division.voc ${MODELS}/batch/division.vpd -l sos2)
+set(ENTRIES plain quotients plain_again)
+set(plain_ARGS)
+set(quotients_ARGS --quotients)
+set(plain_again_ARGS)
+
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK})
+set(MANIFEST "")
+
+foreach(ENTRY ${ENTRIES})
+	string(REPLACE ";" " " LINE "${MODEL};${${ENTRY}_ARGS};-o;${WORK}/batch_${ENTRY}.gms")
+	string(APPEND MANIFEST "${LINE}\n")
+	execute_process(COMMAND ${SDOCONV} ${MODEL} ${${ENTRY}_ARGS} -o ${WORK}/single_${ENTRY}.gms
+		RESULT_VARIABLE RESULT)
+	if(NOT RESULT EQUAL 0)
+		message(FATAL_ERROR "single conversion '${ENTRY}' failed")
+	endif()
+endforeach()
+
+file(WRITE ${WORK}/manifest.txt "${MANIFEST}")
+execute_process(COMMAND ${SDOCONV} --batch ${WORK}/manifest.txt -j 1 RESULT_VARIABLE RESULT)
+if(NOT RESULT EQUAL 0)
+	message(FATAL_ERROR "batch conversion failed")
+endif()
+
+foreach(ENTRY ${ENTRIES})
+	execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK}/batch_${ENTRY}.gms ${WORK}/single_${ENTRY}.gms
+		RESULT_VARIABLE RESULT)
+	if(NOT RESULT EQUAL 0)
+		message(FATAL_ERROR "batch conversion '${ENTRY}' differs from the single conversion")
+	endif()
+endforeach()
@@ -0,0 +1,92 @@
+/* converts a model held in memory through the c interface of the library
+ * usage: convert <mdl> <voc> */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdoconv.h"
+
+typedef struct output {
+   char* data;
+   size_t size;
+} output;
+
+static void append( const char* data, size_t size, void* userData )
+{
+   output* out = (output*) userData;
+   out->data = (char*) realloc( out->data, out->size + size + 1 );
+   memcpy( out->data + out->size, data, size );
+   out->size += size;
+   out->data[out->size] = '\0';
+}
+
+static sdoconv_buffer read_file( const char* path )
+{
+   sdoconv_buffer buffer = { NULL, 0 };
+   char* data;
+   long size;
+   FILE* file = fopen( path, "rb" );
+
+   if( !file )
+      return buffer;
+
+   fseek( file, 0, SEEK_END );
+   size = ftell( file );
+   fseek( file, 0, SEEK_SET );
+   data = (char*) malloc( size > 0 ? size : 1 );
+
+   if( fread( data, 1, size, file ) != (size_t) size )
+      size = 0;
+
+   fclose( file );
+   buffer.data = data;
+   buffer.size = size;
+   return buffer;
+}
+
+int main( int argc, char** argv )
+{
+   const char* options[] = { "--discretization-method=rk4", "-l", "sos2" };
+   const char* invalid[] = { "--method=rk4" };
+   sdoconv_buffer mdl, voc;
+   output out = { NULL, 0 };
+   char error[256];
+
+   if( argc != 3 )
+      return 2;
+
+   mdl = read_file( argv[1] );
+   voc = read_file( argv[2] );
+
+   if( !mdl.data || !voc.data )
+   {
+      printf( "cannot read the model\n" );
+      return 1;
+   }
+
+   if( sdoconv_convert( &mdl, 1, &voc, 1, NULL, options, 3, append, &out, error, sizeof( error ) ) != 0 )
+   {
+      printf( "conversion failed: %s\n", error );
+      return 1;
+   }
+
+   if( !out.data || !strstr( out.data, "Set p discretization sampling points / 0*4 /" ) || !strstr( out.data, "Equation eq_stocka(t, p);" ) )
+   {
+      printf( "unexpected output:\n%s\n", out.data ? out.data : "" );
+      return 1;
+   }
+
+   error[0] = '\0';
+
+   if( sdoconv_convert( &mdl, 1, &voc, 1, NULL, invalid, 1, append, &out, error, sizeof( error ) ) == 0 || !strstr( error, "method" ) )
+   {
+      printf( "unknown option was accepted: %s\n", error );
+      return 1;
+   }
+
+   printf( "converted %lu bytes\n", (unsigned long) out.size );
+   free( out.data );
+   free( (void*) mdl.data );
+   free( (void*) voc.data );
+   return 0;
+}
@@ -0,0 +1,39 @@
+/* escapes names with transliterated letters, removed characters and invalid utf-8, some of
+ * them longer than the 16 bytes the vectorized scan for plain bytes works on */
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include "Escape.hpp"
+
+int main()
+{
+   const std::pair<std::string, std::string> cases[] = {
+      { "café", "cafe" },
+      { "Łódź", "Lodz" },
+      { "Œuvre", "OEuvre" },
+      { "Größe", "Groesse" },
+      { "3×4", "34" },
+      //a byte that does not start a valid utf-8 sequence is a Latin-1 character
+      { "caf\xE9", "cafe" },
+      //a continuation byte without a lead byte is removed
+      { "a\x80" "b", "ab" },
+      { "initial production capacity", "initialproductioncapacity" },
+      { "abcdefghijklmnopqrstuvwxyzé-1", "abcdefghijklmnopqrstuvwxyze1" },
+      { "Bevölkerungsentwicklung der Städte", "BevoelkerungsentwicklungderStaedte" }
+   };
+   int failed = 0;
+
+   for( auto& c : cases )
+   {
+      std::string escaped = gams::escape_string( c.first );
+
+      if( escaped != c.second )
+      {
+         std::cerr << "escape_string( \"" << c.first << "\" ) is \"" << escaped << "\" instead of \"" << c.second << "\"\n";
+         ++failed;
+      }
+   }
+
+   return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+"""Client of the conversion server used by the server tests."""
+
+import os
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+
+def read_full(connection, size):
+    data = b""
+    while len(data) < size:
+        chunk = connection.recv(size - len(data))
+        if not chunk:
+            sys.exit("server closed the connection")
+        data += chunk
+    return data
+
+
+def send(connection, args):
+    """Send a request and return the first line of the response and the gams output."""
+    message = " ".join(args).encode()
+    connection.sendall(struct.pack("!I", len(message)) + message)
+    size, = struct.unpack("!I", read_full(connection, 4))
+    status, _, gams = read_full(connection, size).decode().partition("\n")
+    return status, gams
+
+
+def request(connection, args):
+    """Send a request that must succeed and return its gams output."""
+    status, gams = send(connection, args)
+    if not status.startswith("ok"):
+        sys.exit("request '%s' failed: %s" % (" ".join(args), status))
+    return gams
+
+
+def start_server(sdoconv, path):
+    """Start a server on the socket and return the process and a connection to it."""
+    server = subprocess.Popen([sdoconv, "--serve", path], stderr=subprocess.DEVNULL)
+    for _ in range(100):
+        if os.path.exists(path):
+            break
+        time.sleep(0.1)
+    connection = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    connection.connect(path)
+    return server, connection
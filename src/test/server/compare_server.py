@@ -0,0 +1,33 @@
+"""Converts the same model with and without quotients on one server and compares the
+responses with the output of single runs.
+
+usage: compare_server.py <sdoconv> <models> <work>
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+
+from client import request, start_server
+
+sdoconv, models, work = sys.argv[1:4]
+model = [os.path.join(models, "batch", "division." + ext) for ext in ("mdl", "voc", "vpd")] + ["-l", "sos2"]
+entries = [("plain", []), ("quotients", ["--quotients"]), ("plain_again", [])]
+
+shutil.rmtree(work, ignore_errors=True)
+os.makedirs(work)
+path = os.path.join(work, "socket")
+
+server, connection = start_server(sdoconv, path)
+try:
+    for name, args in entries:
+        served = request(connection, model + args)
+        single = subprocess.run([sdoconv] + model + args, stdout=subprocess.PIPE, check=True).stdout.decode()
+        if served != single:
+            sys.exit("served conversion '%s' differs from the single conversion" % name)
+
+    connection.close()
+finally:
+    server.kill()
+    server.wait()
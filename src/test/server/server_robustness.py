@@ -0,0 +1,56 @@
+"""Checks that the server answers after failing requests, notices files that change within a
+second and does not remove a file that is not a socket.
+
+usage: server_robustness.py <sdoconv> <models> <work>
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+
+from client import request, send, start_server
+
+sdoconv, models, work = sys.argv[1:4]
+
+shutil.rmtree(work, ignore_errors=True)
+os.makedirs(work)
+for ext in ("mdl", "voc", "vpd"):
+    shutil.copy(os.path.join(models, "batch", "division." + ext), work)
+model = [os.path.join(work, "division." + ext) for ext in ("mdl", "voc", "vpd")] + ["-l", "sos2"]
+
+#the server must not take the place of a file that is not a socket
+path = os.path.join(work, "socket")
+with open(path, "w") as file:
+    file.write("not a socket")
+result = subprocess.run([sdoconv, "--serve", path], stderr=subprocess.PIPE, timeout=30)
+if "is not a socket" not in result.stderr.decode() or open(path).read() != "not a socket":
+    sys.exit("the server replaced a file that is not a socket")
+os.remove(path)
+
+server, connection = start_server(sdoconv, path)
+try:
+    #an unknown option throws an exception that is not a runtime error
+    status, _ = send(connection, model + ["--no-such-option"])
+    if not status.startswith("error"):
+        sys.exit("request with an unknown option did not fail: " + status)
+
+    status, _ = send(connection, [os.path.join(work, "missing.mdl"), "-l", "sos2"])
+    if not status.startswith("error"):
+        sys.exit("request of a missing model did not fail: " + status)
+
+    before = request(connection, model)
+
+    #the same number of bytes written right after the first parse
+    mdl = model[0]
+    text = open(mdl).read()
+    with open(mdl, "w") as file:
+        file.write(text.replace("capacity = 5", "capacity = 7"))
+    after = request(connection, model)
+    if "capacity / 7 /" not in after or before == after:
+        sys.exit("the server did not parse the changed model again")
+
+    connection.close()
+finally:
+    server.kill()
+    server.wait()